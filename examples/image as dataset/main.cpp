@@ -62,9 +62,12 @@ int main(int argc, const char * argv[]) {
 
     auto cells = som.getCells();
 
+    vector<size_t> bmuIndices(targetMat.total());
+    som.computeBmuIndices(targetMat.data, targetMat.total(), bmuIndices.data());
+
     for (auto i = 0; i < targetMat.total(); i++) {
         auto pixelIndex0 = i * channels;
-        auto bmuIndex = som.computeBmuIndex(targetMat.data[pixelIndex0]);
+        auto bmuIndex = bmuIndices[i];
 
         for (auto j = 0; j < channels; j++) {
             targetMat.data[pixelIndex0 + j] = cells[bmuIndex].weights[j];
@@ -0,0 +1,211 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef cl_computing_hpp
+#define cl_computing_hpp
+
+#include "computing.hpp"
+#include "kernel.hpp"
+#include <map>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace som {
+    
+    using namespace std;
+    
+    class WeightUpdateKernel;
+    class BmuReductionKernel;
+    class BatchUpdateKernel;
+    class WeightDistanceKernel;
+    
+    // OpenCL backend, the weights and the distances accumulator are resident on the device
+    class CLComputing : public Computing {
+        
+    public:
+        CLComputing(Model&, const Device, const WeightsLayout = DEVICE_LAYOUT);
+        
+        // Shard of a map sharded across devices, only the nodes [nodesBegin, nodesEnd) are searched, updated
+        // and read back. The device keeps all the weights, the other shards reach it through the Model.
+        CLComputing(Model&, cl_device_id, const size_t nodesBegin, const size_t nodesEnd, const WeightsLayout = DEVICE_LAYOUT);
+        ~CLComputing();
+        
+        // Searches running at once, the others wait for a worker to be returned
+        static const size_t MAX_WORKERS_COUNT = 4;
+        
+        // Whether an OpenCL device of the type is present on any platform
+        static bool isAvailable(const Device);
+        
+        // Moves the bounds of the shard, the weights of the nodes it takes over have to be written first
+        void setNodesRange(const size_t begin, const size_t end);
+        
+        using Computing::bmuIndex;
+        using Computing::adjustWeights;
+        
+        cl_float & pointDistances(const size_t index);
+        
+        size_t bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance);
+        void bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices);
+        
+        // Reduced on the device up to WeightDistanceKernel::MAX_TOP_K, larger k sorts the read back distances
+        void topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances);
+        
+        // Runs on a worker checked out for the call, with a queue, kernels and buffers of its own that only share
+        // the weights. The steps still queued are waited for first.
+        void searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances);
+        
+        // Workers created so far, up to MAX_WORKERS_COUNT whatever the number of searching threads
+        size_t getWorkersCount();
+        
+        cl_float & weightDistances();
+        
+        void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius);
+        void adjustWeightsBatch(const double neighbourhoodRadius);
+        void adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule);
+        
+        // Steps of a shard with the BMUs of the vectors searched across all the shards,
+        // the activation states are left to the caller
+        void adjustWeightsBatch(const double neighbourhoodRadius, const cl_uint *bmuIndices);
+        void adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule, const cl_uint *bmuIndices);
+        
+        // The errors are summed on the device, only a few partial sums are read back
+        void errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum);
+        
+        void readModel();
+        void writeModel();
+        
+        // Applies the pending mini-batch results and waits for the queues
+        void finish();
+        
+        // Channel-major on GPUs, node-major otherwise
+        WeightsLayout getWeightsLayout() const;
+        
+    private:
+        // A staging tile of vectors with its BMU indices and schedule. Two slots alternate, so the upload of
+        // tile N + 1 on the transfer queue overlaps the kernels of tile N on the command queue.
+        struct StagingSlot {
+            cl_mem vectorsBuffer;
+            cl_mem bmuIndicesBuffer;
+            cl_mem scheduleBuffer;
+            cl_mem errorsBuffer;
+            size_t capacity;
+            
+            // Completion of the last kernel reading the slot, the next upload waits for it
+            cl_event released;
+            
+            // BMU indices of a mini-batch step, read back without blocking and applied by the next step
+            vector<cl_uint> indices;
+            size_t pendingCount;
+            cl_event indicesRead;
+        };
+        
+        // Uploads count vectors and the optional schedule into the next slot, once its previous kernels are done
+        StagingSlot & stage(const cl_float *vectors, const cl_float *schedule, const size_t count, cl_event *uploaded);
+        void reserveSlot(StagingSlot &, const size_t count);
+        void completeSlot(StagingSlot &);
+        void releaseSlot(StagingSlot &);
+
+        // The Model weights are transposed on the way when the device layout is channel-major
+        void uploadWeights();
+        void downloadWeights();
+        
+        // Buffers created over the Model arrays are synchronized in place by mapping them, the others are copied
+        void readBuffer(const cl_mem &buffer, const size_t size, void *host, const bool inPlace);
+        
+        // Reads the nodes of the shard into the Model array holding elementSize bytes per node
+        void readNodes(const cl_mem &buffer, const size_t elementSize, void *host, const bool inPlace);
+        void writeBuffer(const cl_mem &buffer, const size_t size, const void *host, const bool inPlace);
+        
+        // Whether the device shares the host memory, the weights are shared in the node-major layout only
+        bool sharesWeights() const;
+        
+        // Uploads the data set on the first batch step, it stays on the device between the epochs
+        void reserveData();
+        
+
+        // The state of a search with searchBmuIndices(), the results of a tile are read back before the next one
+        // is uploaded
+        struct Worker {
+            cl_command_queue commandQueue;
+            WeightDistanceKernel *weightDistanceKernel;
+            DistanceMetric metric;
+            
+            cl_mem vectorsBuffer;
+            cl_mem bmuIndicesBuffer;
+            cl_mem distancesBuffer;
+            size_t capacity;
+        };
+        
+        // An idle worker, a new one below MAX_WORKERS_COUNT, or else the next one returned by another search
+        Worker & checkoutWorker();
+        void returnWorker(Worker &);
+        void reserveWorker(Worker &, const size_t count);
+        void releaseWorker(Worker &);
+        
+        // The kernels are built and connected on their first use
+        WeightDistanceKernel * weightDistanceKernel();
+        BatchUpdateKernel * batchUpdateKernel();
+        
+        Device deviceType_;
+        WeightsLayout layout_;
+        bool modelOutdated_;
+        bool zeroCopy_;
+        
+        // Steps were queued on the model queues since the workers last waited for them
+        bool stepsQueued_;
+        
+        size_t nodesBegin_;
+        size_t nodesEnd_;
+        
+        cl_context context_;
+        cl_device_id deviceId_;
+        cl_command_queue commandQueue_;
+        cl_command_queue transferQueue_;
+        
+        cl_mem inputVectorBuffer_;
+        cl_mem pointsBuffer_;
+        cl_mem weightsBuffer_;
+        cl_mem weightDistancesBuffer_;
+        cl_mem distancesAccumulatorBuffer_;
+        cl_mem dataBuffer_;
+        cl_mem dataBmuIndicesBuffer_;
+        cl_mem errorPartialsBuffer_;
+        size_t errorPartialsCapacity_;
+        
+        // Results of a top-k tile, the capacity counts k results per vector
+        cl_mem topKIndicesBuffer_;
+        cl_mem topKDistancesBuffer_;
+        size_t topKCapacity_;
+        
+        StagingSlot staging_[2];
+        size_t stagingIndex_;
+        size_t stagingTileSize_;
+        size_t maxBatchSize_;
+        
+        // Served from the precomputed neighbourhood of the Model
+        vector<cl_float> pointDistances_;
+        
+        map<DistanceMetric, WeightDistanceKernel *> weightDistanceKernels_;
+        WeightUpdateKernel *weightUpdateKernel_;
+        BmuReductionKernel *bmuReductionKernel_;
+        BatchUpdateKernel *batchUpdateKernel_;
+        
+        mutex workersMutex_;
+        condition_variable workersCondition_;
+        vector<Worker *> workers_;
+        vector<Worker *> idleWorkers_;
+    };
+    
+}
+
+#endif /* cl_computing_hpp */
@@ -21,54 +21,78 @@ namespace som {
     
     class Model;
     
-    class TopologicalDistanceKernel;
-    class SADDistanceKernel;
-    class SSDDistanceKernel;
-    class MAEDistanceKernel;
-    class MSEDistanceKernel;
-    class EuclideanDistanceKernel;
-    class ManhattanDistanceKernel;
-    class ChebyshevDistanceKernel;
-    class MinkowskiDistanceKernel;
-    class CanberraDistanceKernel;
-    class CosineDistanceKernel;
-    
+    // Compute backend interface, implemented with OpenCL and with native C++
     class Computing {
         
     public:
-        Computing(Model&, const Device);
-        ~Computing();
+        // Falls back to the native backend when no OpenCL device of the type is present, a device given by its id
+        // is used whatever the type
+        static Computing * create(Model&, const Device, cl_device_id deviceId = nullptr);
+        
+        virtual ~Computing();
         
-        cl_float & pointDistances(const size_t index);
+        virtual cl_float & pointDistances(const size_t index) = 0;
         
+        // Only the BMU index and its distance are read back, the distances stay on the device
         size_t bmuIndex(const cl_float &vector, bool accumulateDistances);
-
-        double error();
+        virtual size_t bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance) = 0;
+        
+        // Batched BMU search, the vectors are uploaded and reduced in as few dispatches as the device memory allows
+        virtual void bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices) = 0;
+        
+        // The k nearest nodes of each vector, nearest first, k indices and k distances per vector.
+        // Ties resolve to the lowest index.
+        virtual void topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances) = 0;
+        
+        // Batched BMU search of the inference, safe from several threads at once while the map isn't trained: the
+        // scratch buffers belong to the call or to the calling thread. The distances are optional.
+        virtual void searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances) = 0;
+        
+        // Distances from the vector to the listed nodes, the vector becomes the one of the last BMU query and the
+        // distances accumulator isn't updated. Returns false without a query when the backend has no faster path than
+        // the full search, the default.
+        virtual bool nodeDistances(const cl_float &vector, const cl_uint *nodes, const size_t count, cl_float *distances);
+        
+        // Reads back the distances of the last BMU query
+        virtual cl_float & weightDistances() = 0;
+        
+        // Applies the training step to the device-resident weights, using the vector of the last BMU query
+        void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate);
+        
+        // Only the nodes within the cutoff radius are visited, the influence keeps the width of the neighbourhood radius
+        virtual void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius) = 0;
+        
+        // Batch SOM step over the whole data set, the distances accumulator isn't updated in this mode
+        virtual void adjustWeightsBatch(const double neighbourhoodRadius) = 0;
+        
+        // Mini-batch step, the schedule holds a (neighbourhood radius, learning rate) pair per vector. Every node moves
+        // towards the influence-weighted mean of the batch by the summed influences, capped at the whole way.
+        // The step may still be in flight on return, the vectors and the schedule stay untouched until the next
+        // step returns, or until finish().
+        virtual void adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule) = 0;
+        
+        // Waits for the steps in flight and applies their activation states
+        virtual void finish();
+        
+        // Quantization error, the mean BMU distance, and topographic error, the share of the vectors whose BMU and
+        // second BMU aren't adjacent. Taken over sampleCount random data vectors, or the whole data set with 0.
+        void errors(double &quantizationError, double &topographicError, const size_t sampleCount = 0);
+        double error(const size_t sampleCount = 0);
+        
+        // Sums of the BMU distances and of the topographic errors of count vectors, in a single pass
+        virtual void errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum) = 0;
+        
+        // The device copies of the weights and distances accumulator are the source of truth, the Model copy is synchronized on demand
+        virtual void readModel() = 0;
+        virtual void writeModel() = 0;
+        
+    protected:
+        Computing(Model&);
         
-    private:
         Model &model_;
         
-        cl_context context_;
-        cl_device_id deviceId_;
-        cl_command_queue commandQueue_;
-        
-        cl_mem inputVectorBuffer_;
-        cl_mem weightsBuffer_;
-        cl_mem weightDistancesBuffer_;
-        
-        SADDistanceKernel *sadDistanceKernel_;
-        SSDDistanceKernel *ssdDistanceKernel_;
-        MAEDistanceKernel *maeDistanceKernel_;
-        MSEDistanceKernel *mseDistanceKernel_;
-        EuclideanDistanceKernel *euclideanDistanceKernel_;
-        ManhattanDistanceKernel *manhattanDistanceKernel_;
-        ChebyshevDistanceKernel *chebyshevDistanceKernel_;
-        MinkowskiDistanceKernel *minkowskiDistanceKernel_;
-        CanberraDistanceKernel *canberraDistanceKernel_;
-        CosineDistanceKernel *cosineDistanceKernel_;
-        TopologicalDistanceKernel *pointDistanceKernel_;
     };
     
 }
 
-#endif /* Computing_hpp */
+#endif /* computing_hpp */
@@ -0,0 +1,49 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef devices_hpp
+#define devices_hpp
+
+#include "types.hpp"
+#include <vector>
+#include <string>
+
+namespace som {
+    
+    using namespace std;
+    
+    // The OpenCL devices of every platform, in the platform order and then in the device order of each platform
+    class Devices {
+        
+    public:
+        static vector<cl_device_id> ids();
+        static vector<DeviceInfo> list();
+        
+        // The first device of the type on any platform, nullptr without one
+        static cl_device_id find(const Device);
+        
+        // The first device whose name contains the text, nullptr without one
+        static cl_device_id find(const string &name);
+        
+        // Times a few BMU searches of a random map of the size on every device and on the native backend.
+        // Returns the index of the fastest device in ids(), or SIZE_MAX when the native backend is the fastest.
+        static size_t fastest(const size_t nodesCount, const size_t channels);
+        
+    private:
+        static DeviceInfo info(const cl_device_id &, const size_t index);
+        
+    };
+    
+}
+
+#endif /* devices_hpp */
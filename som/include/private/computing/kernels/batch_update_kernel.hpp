@@ -0,0 +1,56 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef batch_update_kernel_hpp
+#define batch_update_kernel_hpp
+
+#include "kernel.hpp"
+#include "types.hpp"
+
+namespace som {
+    
+    class Model;
+    
+    // Batch SOM step: the data vectors are summed per BMU on the device, then every node is replaced
+    // with the neighbourhood-weighted mean of these sums.
+    class BatchUpdateKernel : private Kernel {
+        
+    public:
+        BatchUpdateKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        ~BatchUpdateKernel();
+        
+        void connect(const Model &, const cl_mem &weightsBuffer, const cl_mem &pointsBuffer, const WeightsLayout);
+        void accumulate(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count, cl_event *event = nullptr);
+        
+        // The activation counts are added to activationStates unless it's nullptr
+        void compute(const double neighbourhoodRadius, const NeighbourhoodFunction, cl_int *activationStates);
+        
+        // Replaces the nodes [begin, end) only, the clusters are still accumulated over the whole map
+        void setNodesRange(const size_t begin, const size_t end);
+        
+    private:
+        void reset();
+        
+        cl_kernel updateKernel_;
+        
+        cl_mem weightsBuffer_;
+        cl_mem pointsBuffer_;
+        cl_mem clusterSumsBuffer_;
+        cl_mem clusterCountsBuffer_;
+        
+        cl_uint channels_;
+        cl_uint nodesCount_;
+    };
+    
+}
+
+#endif /* batch_update_kernel_hpp */
@@ -0,0 +1,54 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef bmu_reduction_kernel_hpp
+#define bmu_reduction_kernel_hpp
+
+#include "kernel.hpp"
+
+namespace som {
+    
+    class Model;
+    
+    // Two-pass work-group tree reduction of the weight distances to the lowest distance and its node index.
+    // The first pass also accumulates the distances on the device, so only the result is read back.
+    class BmuReductionKernel : private Kernel {
+        
+    public:
+        BmuReductionKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        ~BmuReductionKernel();
+        
+        void connect(const Model &, const cl_mem &distancesBuffer, const cl_mem &accumulatorBuffer);
+        size_t compute(bool accumulateDistances, cl_float &distance);
+        
+        // Reduces the nodes [begin, end) only, the whole map once connected
+        void setNodesRange(const size_t begin, const size_t end);
+        
+        // Work-group reduction of (distance, index) pairs, shared with the kernels that search the BMU
+        static const std::string localReductionCode;
+        static size_t localWorkSize(const cl_kernel &, const cl_device_id &);
+        
+    private:
+        cl_kernel partialsKernel_;
+        
+        cl_mem distancesBuffer_;
+        cl_mem accumulatorBuffer_;
+        cl_mem partialDistancesBuffer_;
+        cl_mem partialIndicesBuffer_;
+        cl_mem resultBuffer_;
+        
+        size_t localWorkSize_[1];
+    };
+    
+}
+
+#endif /* bmu_reduction_kernel_hpp */
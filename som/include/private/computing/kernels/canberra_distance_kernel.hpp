@@ -20,7 +20,7 @@ namespace som {
     class CanberraDistanceKernel : public WeightDistanceKernel {
         
     public:
-        CanberraDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        CanberraDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
@@ -20,7 +20,7 @@ namespace som {
     class ChebyshevDistanceKernel : public WeightDistanceKernel {
         
     public:
-        ChebyshevDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        ChebyshevDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
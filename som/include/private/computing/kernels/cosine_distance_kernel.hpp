@@ -20,7 +20,7 @@ namespace som {
     class CosineDistanceKernel : public WeightDistanceKernel {
         
     public:
-        CosineDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        CosineDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
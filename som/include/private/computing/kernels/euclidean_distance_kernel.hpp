@@ -20,7 +20,7 @@ namespace som {
     class EuclideanDistanceKernel : public WeightDistanceKernel {
         
     public:
-        EuclideanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        EuclideanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
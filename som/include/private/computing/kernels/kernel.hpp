@@ -26,10 +26,18 @@
 
 namespace som {
     
+    // Order of the weights in the device memory. Node-major is the Model order, channel-major lets the
+    // neighbouring work-items of a GPU read neighbouring addresses.
+    enum WeightsLayout {
+        DEVICE_LAYOUT, // Chosen by the device type
+        NODE_MAJOR,
+        CHANNEL_MAJOR
+    };
+    
     class Kernel {
         
     public:
-        Kernel(const std::string code, const std::string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        Kernel(const std::string code, const std::string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string options = "");
         
         ~Kernel();
         
@@ -42,6 +50,9 @@ namespace som {
         
         size_t globalWorkSize_[1];
         
+        // First node of the range the kernels of a sharded map cover, their global ids are the node indices of the whole map
+        size_t globalWorkOffset_[1];
+        
     };
     
 }
@@ -20,7 +20,7 @@ namespace som {
     class MAEDistanceKernel : public WeightDistanceKernel {
         
     public:
-        MAEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        MAEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
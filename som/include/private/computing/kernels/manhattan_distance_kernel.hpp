@@ -20,7 +20,7 @@ namespace som {
     class ManhattanDistanceKernel : public WeightDistanceKernel {
         
     public:
-        ManhattanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        ManhattanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
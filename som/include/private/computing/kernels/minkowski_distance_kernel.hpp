@@ -21,7 +21,7 @@ namespace som {
     class MinkowskiDistanceKernel : public WeightDistanceKernel {
         
     public:
-        MinkowskiDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, Device);
+        MinkowskiDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options, Device);
         
     };
     
@@ -20,7 +20,7 @@ namespace som {
     class MSEDistanceKernel : public WeightDistanceKernel {
         
     public:
-        MSEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        MSEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
@@ -0,0 +1,59 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef program_cache_hpp
+#define program_cache_hpp
+
+#include <string>
+
+#define CL_USE_DEPRECATED_OPENCL_1_2_APIS
+#define CL_SILENCE_DEPRECATION
+
+#ifdef __APPLE__
+#include <OpenCL/OpenCL.h>
+#else
+#include <CL/cl.h>
+#endif
+
+namespace som {
+    
+    using namespace std;
+    
+    // On-disk cache of the built program binaries. An entry is found by the device and the source hash
+    // and is rebuilt when the stored platform, device or driver version doesn't match anymore.
+    // SOM_PROGRAM_CACHE=0 disables the cache, SOM_PROGRAM_CACHE_DIR moves it.
+    class ProgramCache {
+        
+    public:
+        // Returns a built program, from the cached binary when possible
+        static cl_program build(const string &code, cl_context &context, cl_device_id &deviceId, const string &options = "");
+        
+        static void setEnabled(const bool enabled);
+        static bool isEnabled();
+        
+        static void setDirectory(const string &path);
+        static string getDirectory();
+        
+    private:
+        static cl_program buildFromBinary(const string &path, const string &identity, cl_context &context, cl_device_id &deviceId, const string &options);
+        static cl_program buildFromSource(const string &code, cl_context &context, cl_device_id &deviceId, const string &options);
+        
+        static void store(const string &directory, const string &path, const string &identity, const cl_program &program, cl_device_id &deviceId);
+        
+        static string deviceName(const cl_device_id &deviceId);
+        static string deviceIdentity(const cl_device_id &deviceId);
+        
+    };
+    
+}
+
+#endif /* program_cache_hpp */
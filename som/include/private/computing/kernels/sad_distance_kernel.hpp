@@ -20,7 +20,7 @@ namespace som {
     class SADDistanceKernel : public WeightDistanceKernel {
         
     public:
-        SADDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        SADDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
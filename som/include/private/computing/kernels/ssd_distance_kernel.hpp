@@ -20,7 +20,7 @@ namespace som {
     class SSDDistanceKernel : public WeightDistanceKernel {
         
     public:
-        SSDDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        SSDDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options);
         
     };
     
@@ -19,21 +19,72 @@ namespace som {
     
     class Model;
     
+    // Builds the distances, batched BMU, top-k and map error kernels around the metric function
+    // float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride),
+    // specialized with buildOptions(). The metric walks the CHUNKS with loadChunk(inputVector, chunk, padding)
+    // and loadWeights(weights, channelStride, chunk, padding) into VECTOR and reduces with SUM or MAXIMUM.
     class WeightDistanceKernel : private Kernel {
         
     public:
-        WeightDistanceKernel(const std::string code, const std::string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        // Nearest nodes a top-k work-item keeps in its private memory
+        static const size_t MAX_TOP_K = 16;
         
-        void connect(const Model &, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &distancesBuffer);
+        WeightDistanceKernel(const std::string distanceCode, const std::string &options, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        virtual ~WeightDistanceKernel();
+        
+        void connect(const Model &, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &distancesBuffer, const cl_mem &pointsBuffer);
+        
+        // Restricts the distances and the searches to the nodes [begin, end), the whole map once connected.
+        // The results keep the node indices of the whole map.
+        void setNodesRange(const size_t begin, const size_t end);
+        
+        // The vector upload doesn't block, the vector stays untouched until the distances are read
         void compute(const cl_float &vector);
         
+        // One work-group per input vector, reduced to the BMU index of each vector.
+        // The dispatch waits for the optional event and signals the optional completion event.
+        void computeBmuIndices(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count, const cl_event *waitEvent = nullptr, cl_event *event = nullptr);
+        
+        // One work-group per input vector, searched in the nodes [offsets[m], offsets[m + 1]) of its model m. The
+        // node-major weights of several models lie one after the other, the BMU indices count from the first node
+        // of the model. Doesn't need the kernel to be connected.
+        void computePackedBmuIndices(const cl_mem &inputVectorsBuffer, const cl_mem &weightsBuffer, const cl_mem &offsetsBuffer, const cl_mem &modelsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count);
+        
+        // One work-group per input vector. Every work-item keeps the sorted k nearest of its nodes, then k work-group
+        // reductions of the heads of these lists merge them into the k nearest indices and distances, nearest first.
+        // k is at most MAX_TOP_K.
+        void computeTopK(const cl_mem &inputVectorsBuffer, const cl_mem &indicesBuffer, const cl_mem &distancesBuffer, const size_t count, const size_t k, const cl_event *waitEvent = nullptr, cl_event *event = nullptr);
+        
+        // One work-group per input vector, reduced to the BMU distance and to whether the BMU and the second BMU
+        // are further apart than adjacent nodes, a pair of floats per vector. The second BMU is the lowest of the
+        // work-item candidates other than the BMU, so a second reduction finds it.
+        void computeErrors(const cl_mem &inputVectorsBuffer, const cl_mem &errorsBuffer, const size_t count, const cl_float maxAdjacentDistance, const cl_event *waitEvent = nullptr);
+        
+        // Sums the error pairs of count vectors into groupsCount partial sums pairs, written from the pair partialsOffset on.
+        // Every tile gets its own partials, the host adds them up in double.
+        void sumErrors(const cl_mem &errorsBuffer, const size_t count, const cl_mem &partialsBuffer, const size_t partialsOffset, const size_t groupsCount, cl_event *event = nullptr);
+        
+        // The channels count, the vector width and the weights layout are compiled in, the maps of any size share the program
+        static std::string buildOptions(const size_t channels, const WeightsLayout);
+        
+        // float4, float8 or float16
+        static size_t vectorWidth(const size_t channels);
+        
     private:
+        
+        cl_kernel bmuIndicesKernel_;
+        cl_kernel packedBmuIndicesKernel_;
+        cl_kernel topKKernel_;
+        cl_kernel errorsKernel_;
+        cl_kernel sumErrorsKernel_;
+        
         cl_mem inputBuffer_;
         cl_mem weightsBuffer_;
         cl_mem distancesBuffer_;
         
         size_t channels_, nodesCount_;
-        cl_float *weights_, *distances_;
+        size_t localWorkSize_[2];
+        size_t searchWorkOffset_[2];
         
     };
     
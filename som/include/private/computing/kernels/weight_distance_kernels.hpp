@@ -0,0 +1,34 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef weight_distance_kernels_hpp
+#define weight_distance_kernels_hpp
+
+#include "weight_distance_kernel.hpp"
+#include "types.hpp"
+
+namespace som {
+    
+    typedef WeightDistanceKernel * (*WeightDistanceKernelFactory)(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options, const Device);
+    
+    // Metric-indexed registry of the weight distance kernels, a metric is added by registering its factory
+    class WeightDistanceKernels {
+        
+    public:
+        // Builds the kernel of the metric with the WeightDistanceKernel::buildOptions, nullptr for an unregistered metric
+        static WeightDistanceKernel * create(const DistanceMetric, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const std::string &options, const Device);
+        
+    };
+    
+}
+
+#endif /* weight_distance_kernels_hpp */
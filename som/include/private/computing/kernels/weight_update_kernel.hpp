@@ -0,0 +1,72 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef weight_update_kernel_hpp
+#define weight_update_kernel_hpp
+
+#include "kernel.hpp"
+#include "types.hpp"
+
+namespace som {
+    
+    class Model;
+    class Neighbourhood;
+    
+    // Moves the device-resident weights towards the input vector inside the neighbourhood of the BMU.
+    // With the neighbourhood connected, a step dispatches a work-item per node inside the cutoff radius only,
+    // from the table row of the BMU or from the stencil. Otherwise the topological distances are computed in place.
+    class WeightUpdateKernel : private Kernel {
+        
+    public:
+        WeightUpdateKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId);
+        ~WeightUpdateKernel();
+        
+        void connect(const Model &, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &pointsBuffer, const WeightsLayout);
+        void compute(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius, const NeighbourhoodFunction);
+        
+        // Uploads the table or the stencil with its lookup
+        void connect(const Neighbourhood &);
+        bool isNeighbourhoodConnected() const;
+        
+        // The updates cover the nodes [begin, end) only, the whole map once connected. The steps inside the cutoff
+        // radius still dispatch the whole prefix of the table row or the stencil, the other nodes are skipped.
+        void setNodesRange(const size_t begin, const size_t end);
+        
+        // Step of count vectors against the same weights towards their influence-weighted mean, capped at the mean.
+        // The schedule holds (radius, learning rate) pairs
+        void computeMiniBatch(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const cl_mem &scheduleBuffer, const size_t count, const NeighbourhoodFunction, cl_event *event = nullptr);
+        
+        // Device counterpart of InfluenceTable::influence, float influence(distance, squareNeighbourhood, function).
+        // Shared with the batch update kernel.
+        static const std::string neighbourhoodFunctionsCode;
+        
+    private:
+        cl_kernel miniBatchKernel_;
+        cl_kernel tableKernel_;
+        cl_kernel stencilKernel_;
+        
+        const Neighbourhood *neighbourhood_;
+        cl_mem neighboursBuffer_;
+        cl_mem neighbourDistancesBuffer_;
+        cl_mem lookupBuffer_;
+        
+        cl_mem inputBuffer_;
+        cl_mem weightsBuffer_;
+        cl_mem pointsBuffer_;
+        
+        cl_uint channels_;
+        size_t nodesCount_;
+    };
+    
+}
+
+#endif /* weight_update_kernel_hpp */
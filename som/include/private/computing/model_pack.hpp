@@ -0,0 +1,68 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef model_pack_hpp
+#define model_pack_hpp
+
+#include "types.hpp"
+#include <vector>
+
+namespace som {
+    
+    using namespace std;
+    
+    class Model;
+    class WeightDistanceKernel;
+    
+    // The weights of several models with the same channels and metric in one device buffer, node-major and one
+    // model after the other, so the searches of all of them run in a single dispatch. Built in the runtime context
+    // of the device, searched with the native kernels without a device.
+    class ModelPack {
+        
+    public:
+        ModelPack(const vector<const Model *> &models, cl_device_id deviceId);
+        ~ModelPack();
+        
+        // Copies the weights of the models again, after more training
+        void update();
+        
+        // Vector i is searched in the model models[i], the BMU indices count from the first node of that model
+        void bmuIndices(const cl_float &vectors, const cl_uint *models, const size_t count, size_t *bmuIndices);
+        
+    private:
+        void reserve(const size_t count);
+        
+        vector<const Model *> models_;
+        size_t channels_;
+        DistanceMetric metric_;
+        
+        // Model m holds the nodes [offsets_[m], offsets_[m + 1]) of the pack
+        vector<cl_uint> offsets_;
+        vector<cl_float> weights_;
+        
+        cl_device_id deviceId_;
+        cl_context context_;
+        cl_command_queue commandQueue_;
+        WeightDistanceKernel *kernel_;
+        
+        cl_mem weightsBuffer_;
+        cl_mem offsetsBuffer_;
+        cl_mem vectorsBuffer_;
+        cl_mem modelsBuffer_;
+        cl_mem bmuIndicesBuffer_;
+        size_t capacity_;
+    };
+    
+}
+
+#endif /* model_pack_hpp */
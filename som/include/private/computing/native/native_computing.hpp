@@ -0,0 +1,93 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef native_computing_hpp
+#define native_computing_hpp
+
+#include "computing.hpp"
+#include "neighbourhood.hpp"
+#include "influence_table.hpp"
+#include "native_kernels.hpp"
+#include <vector>
+
+namespace som {
+    
+    class ThreadPool;
+    
+    // C++ backend without OpenCL, the Model buffers are used in place and the nodes are sharded across the
+    // threads of the shared pool
+    class NativeComputing : public Computing {
+        
+    public:
+        NativeComputing(Model&);
+        ~NativeComputing();
+        
+        using Computing::bmuIndex;
+        using Computing::adjustWeights;
+        
+        cl_float & pointDistances(const size_t index);
+        
+        size_t bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance);
+        void bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices);
+        void topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances);
+        
+        // Only reads the weights, the batched search is the reentrant one
+        void searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances);
+        
+        bool nodeDistances(const cl_float &vector, const cl_uint *nodes, const size_t count, cl_float *distances);
+        
+        cl_float & weightDistances();
+        
+        void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius);
+        void adjustWeightsBatch(const double neighbourhoodRadius);
+        void adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule);
+        
+        void errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum);
+        
+        // The Model buffers are the source of truth
+        void readModel();
+        void writeModel();
+        
+        const char * getInstructionSet() const;
+        
+        // The searches without accumulated distances abandon the nodes part way once they can't be the BMU,
+        // seeded with the previous BMU. Only for the monotone metrics, the results are those of the full scan.
+        // On by default.
+        void setPartialDistanceSearch(const bool enabled);
+        
+    private:
+        size_t nodesGrain() const;
+        
+        // The bounded search of the metric, nullptr when it's off or the metric isn't monotone
+        NativeBmuFunction boundedBmu() const;
+        
+        const NativeKernels &kernels_;
+        ThreadPool &threadPool_;
+        
+        vector<cl_float> input_;
+        vector<cl_float> pointDistances_;
+        bool distancesOutdated_;
+        
+        bool partialDistanceSearch_;
+        size_t lastBmuIndex_;
+        
+        // Nodes inside the neighbourhood radius of the last online step
+        vector<Neighbourhood::Neighbour> neighbours_;
+        
+        // Influences of the online steps, built with the neighbourhood
+        InfluenceTable *influenceTable_;
+        
+    };
+    
+}
+
+#endif /* native_computing_hpp */
@@ -0,0 +1,61 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef native_kernels_hpp
+#define native_kernels_hpp
+
+#include "types.hpp"
+
+namespace som {
+    
+    static const size_t DISTANCE_METRICS_COUNT = MSE + 1;
+    
+    // Distances from the vector to the nodes [begin, end)
+    typedef void (*NativeDistancesFunction)(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, cl_float *distances);
+    
+    // Fused distance and argmin over the nodes [begin, end), ties resolve to the lowest index.
+    // Returns SIZE_MAX and FLT_MAX when no distance is below FLT_MAX.
+    typedef size_t (*NativeBmuFunction)(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, cl_float &distance);
+    
+    // The BMU of the nodes [begin, end) whose distance doesn't exceed the bound, which tightens as the search goes.
+    // The other nodes are abandoned after part of the channels. Ties resolve to the lowest index, SIZE_MAX is
+    // returned with the bound unchanged when every node is abandoned. Only the metrics whose partial distances
+    // never decrease have one, nullptr otherwise. The distance is the bound on the way in.
+    typedef NativeBmuFunction NativeBoundedBmuFunction;
+    
+    // The node of [begin, end) with the lowest scales[i] * dot(vector, weights of i) + offsets[i], for the searches
+    // through precomputed node norms. Ties resolve to the lowest index, SIZE_MAX and FLT_MAX are returned when no
+    // score is below FLT_MAX.
+    typedef size_t (*NativeDotBmuFunction)(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, const cl_float *scales, const cl_float *offsets, cl_float &score);
+    
+    // Distance kernels of one instruction set, indexed by DistanceMetric
+    struct NativeKernels {
+        const char *name;
+        
+        NativeDistancesFunction distances[DISTANCE_METRICS_COUNT];
+        NativeBmuFunction bmu[DISTANCE_METRICS_COUNT];
+        NativeBoundedBmuFunction boundedBmu[DISTANCE_METRICS_COUNT];
+        NativeDotBmuFunction dotBmu;
+    };
+    
+    const NativeKernels & scalarKernels();
+    
+    // nullptr when the instruction set isn't compiled in or isn't supported by the CPU
+    const NativeKernels * avx2Kernels();
+    const NativeKernels * avx512Kernels();
+    
+    // The widest supported instruction set
+    const NativeKernels & nativeKernels();
+    
+}
+
+#endif /* native_kernels_hpp */
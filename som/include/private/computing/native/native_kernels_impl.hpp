@@ -0,0 +1,284 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+// Distance kernels written against a SIMD vector type, instantiated once per instruction set.
+// The including file defines NATIVE_ISA, the namespace of the instantiation, and NATIVE_ISA::Vector with
+// zero, load, loadPartial, add, sub, mul, div, abs, max, fmadd, sum and maximum.
+
+#ifndef native_kernels_impl_hpp
+#define native_kernels_impl_hpp
+
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <algorithm>
+
+namespace som {
+    
+    namespace NATIVE_ISA {
+        
+        // Channels accumulated between two checks of a bounded distance, a multiple of every vector width
+        static const size_t ABANDON_STRIDE = 64;
+        
+#pragma mark - Metrics
+        
+        struct AbsoluteSum {
+            static constexpr float fill = 0;
+            static constexpr bool maximumReduction = false;
+            static constexpr bool monotone = true;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                acc[0] = V::add(acc[0], V::abs(V::sub(x, w)));
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return acc[0]; }
+        };
+        
+        struct AbsoluteMean : AbsoluteSum {
+            static float finalize(const float *acc, const size_t channels) { return (1.0 / channels) * acc[0]; }
+        };
+        
+        struct SquaredSum {
+            static constexpr float fill = 0;
+            static constexpr bool maximumReduction = false;
+            static constexpr bool monotone = true;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                auto difference = V::sub(x, w);
+                
+                acc[0] = V::fmadd(difference, difference, acc[0]);
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return acc[0]; }
+        };
+        
+        struct SquaredMean : SquaredSum {
+            static float finalize(const float *acc, const size_t channels) { return (1.0 / channels) * acc[0]; }
+        };
+        
+        struct EuclideanNorm : SquaredSum {
+            static float finalize(const float *acc, const size_t channels) { return sqrtf(acc[0]); }
+        };
+        
+        struct MaximumAbsolute {
+            static constexpr float fill = 0;
+            static constexpr bool maximumReduction = true;
+            static constexpr bool monotone = true;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                acc[0] = V::max(V::abs(V::sub(x, w)), acc[0]);
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return acc[0]; }
+        };
+        
+        // Minkowski distance with p=3
+        struct MinkowskiNorm {
+            static constexpr float fill = 0;
+            static constexpr bool maximumReduction = false;
+            static constexpr bool monotone = true;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                auto difference = V::abs(V::sub(x, w));
+                
+                acc[0] = V::fmadd(V::mul(difference, difference), difference, acc[0]);
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return powf(acc[0], 1.0f / 3.0f); }
+        };
+        
+        // The tail is filled with ones, so the missing channels add 0/2 instead of 0/0.
+        // Not monotone, a 0/0 channel turns the partial sum into NaN.
+        struct CanberraSum {
+            static constexpr float fill = 1;
+            static constexpr bool maximumReduction = false;
+            static constexpr bool monotone = false;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                acc[0] = V::add(acc[0], V::div(V::abs(V::sub(x, w)), V::add(V::abs(x), V::abs(w))));
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return acc[0]; }
+        };
+        
+        struct CosineDistance {
+            static constexpr float fill = 0;
+            static constexpr bool maximumReduction = false;
+            static constexpr bool monotone = false;
+            
+            template <typename V> static void step(const typename V::type x, const typename V::type w, typename V::type *acc) {
+                acc[0] = V::fmadd(x, w, acc[0]);
+                acc[1] = V::fmadd(x, x, acc[1]);
+                acc[2] = V::fmadd(w, w, acc[2]);
+            }
+            
+            static float finalize(const float *acc, const size_t channels) { return 1.0 - (acc[0] / (sqrtf(acc[1]) * sqrtf(acc[2]))); }
+        };
+        
+#pragma mark - Kernels
+        
+        template <typename M> inline float finalize(const typename Vector::type *acc, const size_t channels) {
+            float result[3];
+            for (auto j = 0; j < 3; j++) {
+                result[j] = M::maximumReduction ? Vector::maximum(acc[j]) : Vector::sum(acc[j]);
+            }
+            
+            return M::finalize(result, channels);
+        }
+        
+        template <typename M> inline float distance(const float *x, const float *w, const size_t channels) {
+            typename Vector::type acc[3] = {Vector::zero(), Vector::zero(), Vector::zero()};
+            
+            size_t i = 0;
+            for (; i + Vector::width <= channels; i += Vector::width) {
+                M::template step<Vector>(Vector::load(&x[i]), Vector::load(&w[i]), acc);
+            }
+            
+            if (i < channels) {
+                M::template step<Vector>(Vector::loadPartial(&x[i], channels - i, M::fill), Vector::loadPartial(&w[i], channels - i, M::fill), acc);
+            }
+            
+            return finalize<M>(acc, channels);
+        }
+        
+        // Same accumulation as distance(), the node is abandoned as soon as the distance of the channels
+        // accumulated so far exceeds the bound. The terms are non-negative and the rounding is monotone,
+        // so a partial distance never exceeds the full one.
+        template <typename M> inline bool boundedDistance(const float *x, const float *w, const size_t channels, const float bound, float &result) {
+            typename Vector::type acc[3] = {Vector::zero(), Vector::zero(), Vector::zero()};
+            
+            size_t i = 0;
+            while (i + Vector::width <= channels) {
+                auto blockEnd = std::min(i + ABANDON_STRIDE, channels);
+                
+                for (; i + Vector::width <= blockEnd; i += Vector::width) {
+                    M::template step<Vector>(Vector::load(&x[i]), Vector::load(&w[i]), acc);
+                }
+                
+                if (finalize<M>(acc, channels) > bound) {
+                    return false;
+                }
+            }
+            
+            if (i < channels) {
+                M::template step<Vector>(Vector::loadPartial(&x[i], channels - i, M::fill), Vector::loadPartial(&w[i], channels - i, M::fill), acc);
+            }
+            
+            result = finalize<M>(acc, channels);
+            
+            return true;
+        }
+        
+        template <typename M> void distances(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, cl_float *result) {
+            for (auto i = begin; i < end; i++) {
+                result[i] = distance<M>(vector, &weights[i * channels], channels);
+            }
+        }
+        
+        template <typename M> size_t bmu(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, cl_float &lowestDistance) {
+            size_t index = SIZE_MAX;
+            lowestDistance = FLT_MAX;
+            
+            for (auto i = begin; i < end; i++) {
+                auto distance = NATIVE_ISA::distance<M>(vector, &weights[i * channels], channels);
+                
+                if (distance < lowestDistance) {
+                    lowestDistance = distance;
+                    index = i;
+                }
+            }
+            
+            return index;
+        }
+        
+        template <typename M> size_t boundedBmu(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, cl_float &bound) {
+            size_t index = SIZE_MAX;
+            
+            for (auto i = begin; i < end; i++) {
+                float distance;
+                
+                if (!boundedDistance<M>(vector, &weights[i * channels], channels, bound, distance)) {
+                    continue;
+                }
+                
+                // A node at the initial bound is kept, it may precede the node that set the bound
+                if (distance < bound || (distance == bound && index == SIZE_MAX)) {
+                    bound = distance;
+                    index = i;
+                }
+            }
+            
+            return index;
+        }
+        
+        inline float dot(const float *x, const float *w, const size_t channels) {
+            auto acc = Vector::zero();
+            
+            size_t i = 0;
+            for (; i + Vector::width <= channels; i += Vector::width) {
+                acc = Vector::fmadd(Vector::load(&x[i]), Vector::load(&w[i]), acc);
+            }
+            
+            if (i < channels) {
+                acc = Vector::fmadd(Vector::loadPartial(&x[i], channels - i, 0), Vector::loadPartial(&w[i], channels - i, 0), acc);
+            }
+            
+            return Vector::sum(acc);
+        }
+        
+        inline size_t dotBmu(const cl_float *vector, const cl_float *weights, const size_t channels, const size_t begin, const size_t end, const cl_float *scales, const cl_float *offsets, cl_float &lowestScore) {
+            size_t index = SIZE_MAX;
+            lowestScore = FLT_MAX;
+            
+            for (auto i = begin; i < end; i++) {
+                auto score = scales[i] * dot(vector, &weights[i * channels], channels) + offsets[i];
+                
+                if (score < lowestScore) {
+                    lowestScore = score;
+                    index = i;
+                }
+            }
+            
+            return index;
+        }
+        
+        template <typename M> constexpr NativeBoundedBmuFunction boundedBmuFunction() {
+            return M::monotone ? boundedBmu<M> : nullptr;
+        }
+        
+        // In the order of DistanceMetric
+        inline NativeKernels kernels(const char *name) {
+            return {
+                name,
+                {
+                    distances<EuclideanNorm>, distances<AbsoluteSum>, distances<MaximumAbsolute>, distances<MinkowskiNorm>, distances<CanberraSum>,
+                    distances<CosineDistance>, distances<AbsoluteSum>, distances<SquaredSum>, distances<AbsoluteMean>, distances<SquaredMean>
+                },
+                {
+                    bmu<EuclideanNorm>, bmu<AbsoluteSum>, bmu<MaximumAbsolute>, bmu<MinkowskiNorm>, bmu<CanberraSum>,
+                    bmu<CosineDistance>, bmu<AbsoluteSum>, bmu<SquaredSum>, bmu<AbsoluteMean>, bmu<SquaredMean>
+                },
+                {
+                    boundedBmuFunction<EuclideanNorm>(), boundedBmuFunction<AbsoluteSum>(), boundedBmuFunction<MaximumAbsolute>(),
+                    boundedBmuFunction<MinkowskiNorm>(), boundedBmuFunction<CanberraSum>(), boundedBmuFunction<CosineDistance>(),
+                    boundedBmuFunction<AbsoluteSum>(), boundedBmuFunction<SquaredSum>(), boundedBmuFunction<AbsoluteMean>(),
+                    boundedBmuFunction<SquaredMean>()
+                },
+                dotBmu
+            };
+        }
+        
+    }
+    
+}
+
+#endif /* native_kernels_impl_hpp */
@@ -0,0 +1,60 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace som {
+    
+    using namespace std;
+    
+    class ThreadPool {
+        
+    public:
+        ThreadPool(const size_t threadsCount);
+        ~ThreadPool();
+        
+        // Process-wide pool with a thread per hardware thread
+        static ThreadPool & shared();
+        
+        // Splits [0, count) into contiguous ranges of at least grain items, the calling thread takes part
+        // and returns when all ranges are done
+        void parallelFor(const size_t count, const size_t grain, const function<void(size_t begin, size_t end)> &task);
+        
+        // Runs the task on one of the threads, the future is ready once it's done. Needs at least one thread.
+        future<void> submit(function<void()> task);
+        
+        size_t getThreadsCount() const;
+        
+    private:
+        void work();
+        
+        vector<thread> threads_;
+        queue<function<void()>> tasks_;
+        
+        mutex mutex_;
+        condition_variable condition_;
+        bool stopping_;
+        
+    };
+    
+}
+
+#endif /* thread_pool_hpp */
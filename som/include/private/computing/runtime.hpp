@@ -0,0 +1,54 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef runtime_hpp
+#define runtime_hpp
+
+#include "types.hpp"
+#include <map>
+#include <mutex>
+#include <future>
+#include <string>
+
+namespace som {
+    
+    using namespace std;
+    
+    // Process-wide OpenCL state shared by the models: a context per device and the programs built in these
+    // contexts. A model creates its queues, buffers and kernels, so it never waits on the work of the others.
+    class Runtime {
+        
+    public:
+        static Runtime & shared();
+        
+        // Created on the first use of the device, the caller retains it if kept
+        cl_context context(const cl_device_id &deviceId);
+        
+        // Built once per context, code and options in the runtime contexts, through ProgramCache in any other.
+        // The builds run outside the lock, the callers of a program being built wait for it. The caller releases
+        // the returned program.
+        cl_program program(const string &code, cl_context &context, cl_device_id &deviceId, const string &options);
+        
+    private:
+        Runtime();
+        ~Runtime();
+        
+        mutex mutex_;
+        map<cl_device_id, cl_context> contexts_;
+        map<pair<cl_context, string>, shared_future<cl_program>> programs_;
+        
+    };
+    
+}
+
+#endif /* runtime_hpp */
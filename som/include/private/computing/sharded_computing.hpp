@@ -0,0 +1,93 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef sharded_computing_hpp
+#define sharded_computing_hpp
+
+#include "computing.hpp"
+#include <vector>
+#include <functional>
+
+namespace som {
+    
+    using namespace std;
+    
+    class CLComputing;
+    
+    // Nodes sharded across OpenCL devices by contiguous ranges. Every device searches and updates the nodes of
+    // its range, the host merges the per-shard winners. The ranges follow the measured throughput of the devices.
+    class ShardedComputing : public Computing {
+        
+    public:
+        ShardedComputing(Model&, const vector<cl_device_id> &deviceIds);
+        ~ShardedComputing();
+        
+        using Computing::bmuIndex;
+        using Computing::adjustWeights;
+        
+        cl_float & pointDistances(const size_t index);
+        
+        size_t bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance);
+        void bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices);
+        void topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances);
+        
+        // The per-shard results are local to the call
+        void searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances);
+        
+        cl_float & weightDistances();
+        
+        // The steps are applied by every shard to its own nodes, with the BMUs merged across the shards
+        void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius);
+        void adjustWeightsBatch(const double neighbourhoodRadius);
+        void adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule);
+        
+        void errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum);
+        
+        void readModel();
+        void writeModel();
+        
+        void finish();
+        
+        // Times a few searches on every device and resizes the ranges to their throughput, done on creation
+        void balance();
+        
+        size_t getShardsCount() const;
+        
+        // Nodes [begin, end) of the shard
+        size_t getShardBegin(const size_t shard) const;
+        size_t getShardEnd(const size_t shard) const;
+        
+    private:
+        // Runs the task for every shard at once, each device is driven by its own thread
+        void forEachShard(const function<void(size_t shard)> &task);
+        
+        // The k nearest of the shard results, nearest first and ties to the lowest index
+        void mergeTopK(const size_t count, const size_t k, size_t *indices, cl_float *distances);
+        
+        vector<CLComputing *> shards_;
+        
+        // Shard i owns the nodes [bounds_[i], bounds_[i + 1])
+        vector<size_t> bounds_;
+        
+        vector<cl_float> pointDistances_;
+        
+        // Per-shard results of the last search, k per vector
+        vector<vector<size_t>> shardIndices_;
+        vector<vector<cl_float>> shardDistances_;
+        
+        vector<cl_uint> bmuIndices_;
+    };
+    
+}
+
+#endif /* sharded_computing_hpp */
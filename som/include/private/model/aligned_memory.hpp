@@ -0,0 +1,50 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef aligned_memory_hpp
+#define aligned_memory_hpp
+
+#include <cstdlib>
+#include <algorithm>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace som {
+    
+    // CL_MEM_USE_HOST_PTR buffers are zero-copy on most drivers with a page-aligned pointer and a size in whole cache lines
+    static const size_t MEMORY_ALIGNMENT = 4096;
+    static const size_t CACHE_LINE_SIZE = 64;
+    
+    inline void * alignedAlloc(const size_t size) {
+        auto paddedSize = std::max(CACHE_LINE_SIZE, (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+        
+#ifdef _WIN32
+        return _aligned_malloc(paddedSize, MEMORY_ALIGNMENT);
+#else
+        void *memory = nullptr;
+        return posix_memalign(&memory, MEMORY_ALIGNMENT, paddedSize) == 0 ? memory : nullptr;
+#endif
+    }
+    
+    inline void alignedFree(void *memory) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+    
+}
+
+#endif /* aligned_memory_hpp */
@@ -41,6 +41,12 @@ namespace som {
         size_t getTopologicalDimensionality() const;
         size_t getNodesCount() const;
         
+        // Axial coordinates of the nodes
+        const vector<Hex> & getHexes() const;
+        
+        // Topological translation by an axial offset, the same from every node
+        Point getTranslation(const Hex &offset) const;
+        
         virtual size_t getCols();
         virtual size_t getRows();
         virtual int getRaduis();
@@ -52,6 +58,8 @@ namespace som {
         cl_float *points_;
         cl_float *corners_;
         
+        vector<Hex> hexes_;
+        
         Size size_;
         Offset offset_;
         
@@ -0,0 +1,60 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef influence_table_hpp
+#define influence_table_hpp
+
+#include <vector>
+#include "types.hpp"
+
+namespace som {
+    
+    using namespace std;
+    
+    class Neighbourhood;
+    
+    // Influences of the neighbourhood function for the current radius, indexed by the squared distance in
+    // the adjacent node units. The hexagonal lattice has a few distinct distances within the radius,
+    // so a step looks them up instead of evaluating the function per node.
+    class InfluenceTable {
+        
+    public:
+        InfluenceTable(const Neighbourhood &);
+        
+        // Rebuilt only when the function or the radius changes
+        void update(const NeighbourhoodFunction, const double neighbourhoodRadius);
+        
+        // For the squared distances within the radius
+        cl_float operator()(const cl_float squaredDistance) const;
+        
+        static cl_float influence(const NeighbourhoodFunction, const cl_float squaredDistance, const cl_float squaredRadius);
+        
+        // Radius past which the influence is below the threshold, the radius itself for the functions
+        // without a decaying tail
+        static double cutoffRadius(const NeighbourhoodFunction, const double neighbourhoodRadius, const double threshold);
+        
+    private:
+        cl_float squaredSpacing_;
+        
+        NeighbourhoodFunction function_;
+        double neighbourhoodRadius_;
+        
+        vector<cl_float> table_;
+    };
+    
+    inline cl_float InfluenceTable::operator()(const cl_float squaredDistance) const {
+        return table_[(size_t)(squaredDistance / squaredSpacing_ + 0.5f)];
+    }
+    
+}
+
+#endif /* influence_table_hpp */
@@ -0,0 +1,126 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef neighbourhood_hpp
+#define neighbourhood_hpp
+
+#include <vector>
+#include "grid.hpp"
+
+namespace som {
+    
+    using namespace std;
+    
+    // Topological neighbourhood of the grid nodes, built once per map. Small maps keep a node-to-node
+    // table with the rows sorted by distance. Larger ones keep the axial offsets sorted by distance,
+    // which are the same from every node, and translate them to the node.
+    class Neighbourhood {
+        
+    public:
+        // Maps up to this many nodes use the table
+        static const size_t MAX_TABLE_NODES = 1024;
+        
+        struct Neighbour {
+            cl_uint index;
+            cl_float squaredDistance;
+        };
+        
+        struct StencilOffset {
+            cl_int dq, dr;
+            cl_float squaredDistance;
+        };
+        
+        Neighbourhood(const Grid &, const size_t maxTableNodes = MAX_TABLE_NODES);
+        
+        // Calls visitor(index, squaredDistance) for the nodes within the radius of the node, nearest first
+        template <typename Visitor>
+        void visit(const size_t node, const double radius, Visitor visitor) const;
+        
+        // Length of the nearest-first prefix within the radius, of the table row of the node or of the stencil
+        size_t prefixLength(const size_t node, const double radius) const;
+        
+        // Squared topological distances from the node to every node
+        void squaredDistances(const size_t node, cl_float *distances) const;
+        
+        bool hasTable() const;
+        
+        // The table holds nodesCount rows of nodesCount neighbours
+        const vector<Neighbour> & getTable() const;
+        
+        // The stencil is resolved with the lookup of the node indices over the bounding box of the axial coordinates,
+        // -1 where there is no node
+        const vector<StencilOffset> & getStencil() const;
+        const vector<cl_int> & getLookup() const;
+        const vector<cl_int> & getCoordinates() const;
+        
+        size_t getLookupCols() const;
+        size_t getLookupRows() const;
+        
+        size_t getNodesCount() const;
+        
+        // Squared distance between adjacent nodes, every squared distance on the hexagonal lattice is a whole multiple of it
+        cl_float getSquaredSpacing() const;
+        
+    private:
+        void buildTable(const Grid &);
+        void buildStencil(const Grid &);
+        
+        size_t nodesCount_;
+        cl_float squaredSpacing_;
+        
+        vector<Neighbour> table_;
+        
+        vector<StencilOffset> stencil_;
+        vector<cl_int> lookup_;
+        vector<cl_int> coordinates_;
+        size_t lookupCols_, lookupRows_;
+    };
+    
+    template <typename Visitor>
+    void Neighbourhood::visit(const size_t node, const double radius, Visitor visitor) const {
+        auto length = prefixLength(node, radius);
+        
+        if (hasTable()) {
+            const Neighbour *row = &table_[node * nodesCount_];
+            
+            for (auto i = 0; i < length; i++) {
+                visitor(row[i].index, row[i].squaredDistance);
+            }
+            
+            return;
+        }
+        
+        int q = coordinates_[node * 2];
+        int r = coordinates_[node * 2 + 1];
+        
+        for (auto i = 0; i < length; i++) {
+            auto &offset = stencil_[i];
+            
+            int col = q + offset.dq;
+            int row = r + offset.dr;
+            
+            if (col < 0 || row < 0 || col >= lookupCols_ || row >= lookupRows_) {
+                continue;
+            }
+            
+            cl_int index = lookup_[col * lookupRows_ + row];
+            
+            if (index >= 0) {
+                visitor((cl_uint)index, offset.squaredDistance);
+            }
+        }
+    }
+    
+}
+
+#endif /* neighbourhood_hpp */
@@ -21,6 +21,7 @@
 namespace som {
     
     class Normalizer;
+    class Neighbourhood;
     
     class Model {
         
@@ -38,8 +39,11 @@ namespace som {
         
         cl_float & normalizeVector(const vector<cl_float> &inputVector);
         cl_float & normalizeVector(const uint8_t *inputVector);
+        cl_float & normalizeVectors(const cl_float *inputVectors, const size_t count, cl_float *dst);
+        cl_float & normalizeVectors(const uint8_t *inputVectors, const size_t count, cl_float *dst);
         
         void setMetric(DistanceMetric);
+        void setNeighbourhoodFunction(NeighbourhoodFunction);
         void setRandomWeights(const double min, const double max);
         void setLabel(cl_int label, size_t index);
         void setLabels(vector<cl_int> labels, vector<size_t> indices);
@@ -49,8 +53,12 @@ namespace som {
         double getTopologicalRadius() const;
         
         cl_float & getRandomDataVector();
+        size_t getRandomDataIndex();
         cl_float & getData() const;
         cl_float & getPoints() const;
+        
+        // Built on the first use
+        const Neighbourhood & getNeighbourhood();
         cl_int   & getLabels() const;
         cl_float & getDistances() const;
         cl_float & getDistancesAccumulator() const;
@@ -65,6 +73,8 @@ namespace som {
         vector<Cell> getCells() const;
         
         DistanceMetric getMetric() const;
+        const Normalizer & getNormalizer() const;
+        NeighbourhoodFunction getNeighbourhoodFunction() const;
 
     private:
         bool create();
@@ -75,8 +85,10 @@ namespace som {
         
         Grid *grid_;
         Normalizer *normalizer_;
+        Neighbourhood *neighbourhood_;
         
         DistanceMetric metric_;
+        NeighbourhoodFunction neighbourhoodFunction_;
         
         vector<Cell> cells_;
         
@@ -84,6 +96,8 @@ namespace som {
         size_t nodesCount_;
         size_t channelsCount_;
         
+        // The data, weights and distances are page-aligned and padded to whole cache lines,
+        // so OpenCL devices with unified memory can use them in place
         cl_float *input_;
         cl_float *data_;
         cl_int   *labels_;
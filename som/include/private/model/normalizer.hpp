@@ -27,6 +27,7 @@ namespace som {
         
     public:
         Normalizer(const size_t channels);
+        Normalizer(const Normalizer &);
         ~Normalizer();
         
         void load(ifstream &is);
@@ -39,6 +40,10 @@ namespace som {
         cl_float & normalize(const vector<cl_float> &src, cl_float &dst);
         cl_float & normalize(const uint8_t *src, cl_float &dst);
         
+        // Normalizes count vectors with the parameters of the data
+        cl_float & normalizeVectors(const cl_float *src, const size_t count, cl_float *dst);
+        cl_float & normalizeVectors(const uint8_t *src, const size_t count, cl_float *dst);
+        
     private:
         template <typename T> cl_float & normalizeData(const T *src, const size_t lenght, cl_float *dst);
         template <typename T> cl_float & normalizeVector(const T *src, cl_float &dst);
@@ -14,6 +14,8 @@
 #define trainer_hpp
 
 #include <iostream>
+#include <vector>
+#include "types.hpp"
 
 namespace som {
     
@@ -27,22 +29,60 @@ namespace som {
     public:
         Trainer(Model&, Computing&);
         
-        void learn(const size_t iterationsCount, const double learningRate, bool epochMode);
+        void learn(const size_t iterationsCount, const double learningRate, bool epochMode, const Training);
         bool epoch();
+        
+        void setMiniBatchSize(const size_t);
+        void setNeighbourhoodThreshold(const double);
+        
+        // The ONLINE steps search the rings of growing radius around the last BMU of the data vector first, and
+        // fall back to the full search when the local minimum isn't enclosed or has drifted. Meant for the late
+        // training, when the map is ordered. The distances accumulator is only updated by the full searches.
+        void setFastWinnerSearch(const bool enabled);
+        
+        // Since the start of the training, the local searches and the ones of them that fell back to the full search
+        size_t getLocalSearchesCount() const;
+        size_t getFallbacksCount() const;
     
     private:
-        void adjustWeights(const cl_float *inputVector, const size_t nodeIndex);
+        // False when the search has to fall back to the full one
+        bool localBmuIndex(const size_t dataIndex, const cl_float &vector, size_t &bmuIndex);
+        
+        void onlineStep();
+        void batchStep();
+        void miniBatchStep();
         
         Model &model_;
         Computing &computing_;
         
+        Training training_;
+        
+        size_t miniBatchSize_;
+        double neighbourhoodThreshold_;
+        
+        // The BMU of each data vector at its last ONLINE step and its distance, UINT_MAX before the first one
+        bool fastWinnerSearch_;
+        vector<cl_uint> lastBmuIndices_;
+        vector<cl_float> lastBmuDistances_;
+        size_t localSearchesCount_;
+        size_t fallbacksCount_;
+        
+        // Nodes of the rings around the last BMU, nearest first, with their distances to the vector
+        vector<cl_uint> ringNodes_;
+        vector<size_t> ringNumbers_;
+        vector<cl_float> ringDistances_;
+        
+        // Double-buffered, the next mini-batch is drawn while the previous one is still in flight
+        vector<cl_float> miniBatches_[2];
+        vector<cl_float> schedules_[2];
+        size_t miniBatchIndex_;
+        
         size_t iterationCount_;
         size_t remainingIterationsCount_;
         
         double timeConstant_;
         double neighbourhoodRadius_;
         double topologicalRadius_;
-        double influence_;
         double learningRate_;
         double startLearningRate_;
     };
@@ -0,0 +1,94 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef frozen_som_hpp
+#define frozen_som_hpp
+
+#include "types.hpp"
+#include <vector>
+#include <string>
+
+namespace som {
+    
+    using namespace std;
+    
+    class Normalizer;
+    
+    // A trained map reduced to what the predictions need: the weights, the labels and the normalization of the data.
+    // There's no grid, no training state and no OpenCL, the searches run on the CPU. It doesn't change after it's
+    // built, so any number of threads predict with it at once. Built by SOM::freeze() or loaded from a file saved by SOM::save().
+    class FrozenSOM {
+        
+    public:
+        FrozenSOM();
+        ~FrozenSOM();
+        
+        // Reads only the normalization, the weights and the labels of the file.
+        // With the norms, the EUCLIDEAN, SSD, MSE and COSINE searches come down to a dot product per node, see precomputeNorms().
+        bool load(const string &filePath, const bool withNorms = false);
+        
+        // Keeps the squared norm of every node for the Euclidean metrics, as |x - w|^2 = |x|^2 - 2 x.w + |w|^2,
+        // and the inverse norm for COSINE. The other metrics are searched as before. Nodes at an equal distance
+        // may resolve differently, the rounding of the expansion isn't that of the direct distance.
+        void precomputeNorms();
+        bool hasNorms() const;
+        
+        int predict(const vector<float> &vector) const;
+        int predict(const uint8_t &pixel) const;
+        
+        size_t computeBmuIndex(const vector<float> &vector) const;
+        size_t computeBmuIndex(const uint8_t &pixel) const;
+        
+        // Batched usage, data holds count vectors of the node dimensionality
+        void predictBatch(const float *data, const size_t count, int *labels) const;
+        void predictBatch(const uint8_t *pixelBuffer, const size_t count, int *labels) const;
+        
+        void computeBmuIndices(const float *data, const size_t count, size_t *bmuIndices) const;
+        void computeBmuIndices(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const;
+        
+        size_t getNodeDimensionality() const;
+        size_t getNodesCount() const;
+        DistanceMetric getMetric() const;
+        
+    private:
+        friend class SOM;
+        
+        FrozenSOM(const FrozenSOM &) = delete;
+        FrozenSOM & operator=(const FrozenSOM &) = delete;
+        
+        // Lays out the weights and the labels of a map of the size, filled in by the caller
+        void allocate(const size_t nodesCount, const size_t channels);
+        void release();
+        
+        void search(const cl_float *inputs, const size_t count, size_t *bmuIndices) const;
+        
+        size_t nodesCount_;
+        size_t channels_;
+        DistanceMetric metric_;
+        
+        Normalizer *normalizer_;
+        
+        // The weights, the labels and the node norms in a single aligned block, each part starts a cache line
+        void *memory_;
+        cl_float *weights_;
+        cl_int *labels_;
+        
+        // Per-node terms of the norm searches, the lowest scale * x.w + offset is the BMU
+        cl_float *scales_;
+        cl_float *offsets_;
+        
+    };
+    
+}
+
+#endif /* frozen_som_hpp */
@@ -13,6 +13,7 @@
 #ifndef som_hpp
 #define som_hpp
 
+#include <future>
 #include "types.hpp"
 
 namespace som {
@@ -22,12 +23,29 @@ namespace som {
     class Model;
     class Trainer;
     class Computing;
+    class FrozenSOM;
     
     class SOM {
         
     public:
         SOM(const Device);
         ~SOM();
+        
+        // Built OpenCL programs are cached on disk, in the user cache directory by default
+        static void setProgramCacheEnabled(const bool enabled);
+        static void setProgramCacheDirectory(const string &path);
+        
+        // The OpenCL devices of every platform
+        static vector<DeviceInfo> getDevices();
+        
+        // Picks the OpenCL device of the next create or load, by its index in getDevices() or by a part of its name.
+        // Returns false without a match, the device type of the constructor is kept then.
+        bool selectDevice(const size_t index);
+        bool selectDevice(const string &name);
+        
+        // Times a few BMU searches of a map of the size on every OpenCL device and on the native backend, then
+        // picks the fastest for the next create or load. Returns its index in getDevices(), SIZE_MAX for the native backend.
+        size_t selectFastestDevice(const size_t nodesCount, const size_t channels);
 
         // Create
         bool create(const size_t cols, const size_t rows, const size_t hexSize, const size_t channels);
@@ -36,27 +54,76 @@ namespace som {
         bool load(const string &filePath);
         bool save(const string &filePath);
         
+        // A copy of the trained map for the predictions only, see FrozenSOM. nullptr without a map, the caller deletes it.
+        FrozenSOM * freeze(const bool withNorms = false) const;
+        
         // Prepare
         void prepare(const vector<vector<float>> &data, const Normalization = NO_NORM, const InitialWeights = RANDOM_FROM_DATA);
         void prepare(const uint8_t *pixelBuffer, const size_t lenght, const Normalization = NO_NORM, const InitialWeights = RANDOM_FROM_DATA);
         
         // Training
-        void train(const size_t epochs, const double learningRate, const DistanceMetric = EUCLIDEAN, bool manual = false);
+        // In the BATCH mode an epoch is a pass over the whole data set and the learning rate isn't used
+        void train(const size_t epochs, const double learningRate, const DistanceMetric = EUCLIDEAN, bool manual = false, const Training = ONLINE);
         bool train(size_t epochs);
         
+        // Trains on a worker thread, the SOM isn't used until the future is ready
+        future<void> trainAsync(const size_t epochs, const double learningRate, const DistanceMetric = EUCLIDEAN, const Training = ONLINE);
+        
+        // Vectors per step of the MINI_BATCH mode, 64 by default
+        void setMiniBatchSize(const size_t size);
+        
+        // The ONLINE steps skip the nodes whose influence is below the threshold, 0 by default
+        void setNeighbourhoodThreshold(const double threshold);
+        
+        // Gaussian by default, see NeighbourhoodFunction
+        void setNeighbourhoodFunction(const NeighbourhoodFunction function);
+        
+        // The ONLINE steps first search around the last BMU of each vector, off by default. Meant for the late
+        // training, the steps found locally don't update the distances accumulator. The OpenCL backends keep
+        // searching every node.
+        void setFastWinnerSearch(const bool enabled);
+        
+        // Local searches since the start of the training, and the ones that fell back to the full search
+        size_t getLocalSearchesCount() const;
+        size_t getFallbacksCount() const;
+        
         // Usage
         void setLabel(int label, size_t index);
         void setLabels(vector<int> labels, vector<size_t> indices);
         
         void setRandomWeights(const float min, const float max);
         
+        // The predictions and the BMU searches are safe from several threads at once while the map isn't trained,
+        // each call searches with its own buffers, and on OpenCL with a queue of the calling thread
         int predict(const vector<float> &vector) const;
         int predict(const uint8_t &pixel) const;
         
         size_t computeBmuIndex(const vector<float> &vector) const;
         size_t computeBmuIndex(const uint8_t &pixel) const;
         
-        double computeError();
+        // Batched usage, data holds count vectors of the node dimensionality
+        void predictBatch(const float *data, const size_t count, int *labels) const;
+        void predictBatch(const uint8_t *pixelBuffer, const size_t count, int *labels) const;
+        
+        void computeBmuIndices(const float *data, const size_t count, size_t *bmuIndices) const;
+        void computeBmuIndices(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const;
+        
+        // The k nearest nodes of each vector, nearest first: k indices and k distances per vector.
+        // k is at most the nodes count, up to 16 the search is reduced on the device.
+        void computeTopK(const float *data, const size_t count, const size_t k, size_t *indices, float *distances) const;
+        void computeTopK(const uint8_t *pixelBuffer, const size_t count, const size_t k, size_t *indices, float *distances) const;
+        
+        // The data is normalized before the call returns, the search runs on a fixed pool of threads shared by
+        // the SOMs and fills bmuIndices. The SOM isn't trained until the future is ready.
+        future<void> computeBmuIndicesAsync(const float *data, const size_t count, size_t *bmuIndices) const;
+        future<void> computeBmuIndicesAsync(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const;
+        
+        // Quantization error over the data set, or over a random subsample of sampleCount vectors
+        double computeError(const size_t sampleCount = 0);
+        
+        // The quantization error and the topographic error, the share of the vectors whose BMU and second BMU
+        // aren't adjacent, in a single pass
+        void computeErrors(double &quantizationError, double &topographicError, const size_t sampleCount = 0);
         
         // Release memory
         void release();
@@ -71,7 +138,10 @@ namespace som {
         size_t getTopologicalDimensionality() const;
 
     private:
+        friend class SOMPack;
+        
         Device deviceType_;
+        cl_device_id deviceId_;
         
         Model *model_;
         Trainer *trainer_;
@@ -0,0 +1,49 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#ifndef som_pack_hpp
+#define som_pack_hpp
+
+#include "som.hpp"
+
+namespace som {
+    
+    using namespace std;
+    
+    class ModelPack;
+    
+    // Trained SOMs of the same node dimensionality and distance metric searched together, the vectors of all of
+    // them in a single dispatch on the device of the first SOM. The weights are copied when the pack is built,
+    // update() copies them again after more training. The SOMs outlive the pack.
+    class SOMPack {
+        
+    public:
+        SOMPack(const vector<const SOM *> &soms);
+        ~SOMPack();
+        
+        void update();
+        
+        // Vector i is searched in soms[somIndices[i]], data holds count vectors of the node dimensionality.
+        // The BMU indices are those of the map of each vector.
+        void computeBmuIndices(const float *data, const size_t *somIndices, const size_t count, size_t *bmuIndices) const;
+        void predictBatch(const float *data, const size_t *somIndices, const size_t count, int *labels) const;
+        
+    private:
+        vector<const SOM *> soms_;
+        ModelPack *pack_;
+        
+    };
+    
+}
+
+#endif /* som_pack_hpp */
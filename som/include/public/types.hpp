@@ -14,6 +14,7 @@
 #define types_hpp
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #define CL_USE_DEPRECATED_OPENCL_1_2_APIS
@@ -33,9 +34,30 @@ namespace som {
     
 #pragma mark - Types
     
-    enum Device { ALL_DEVICES, CPU, GPU };
+    enum Device {
+        ALL_DEVICES, // First OpenCL device
+        CPU,         // OpenCL CPU device
+        GPU,         // OpenCL GPU device
+        NATIVE,      // Multithreaded C++ backend without OpenCL, also chosen when no OpenCL device is found
+        MULTI_DEVICE // Every OpenCL device of every platform, the nodes are sharded across them
+    };
     enum Normalization { NO_NORM, MINMAX_BY_COLUMNS, MINMAX_BY_ROWS };
     enum InitialWeights { RANDOM_0_1, RANDOM_FROM_DATA };
+    
+    enum Training {
+        ONLINE,     // Kohonen rule, one random data vector per iteration
+        BATCH,      // Batch SOM, each iteration replaces the weights with the neighbourhood-weighted means of the whole data set
+        MINI_BATCH  // Kohonen rule, the nodes move at once towards the weighted means of a mini-batch of random data vectors
+    };
+    
+    // Influence of a node at the topological distance d from the BMU, every function is cut at the radius r
+    enum NeighbourhoodFunction {
+        GAUSSIAN,     // exp(-d^2 / 2r^2), the default
+        BUBBLE,       // 1, the same step for the whole neighbourhood
+        MEXICAN_HAT,  // (1 - 2d^2 / r^2) exp(-d^2 / r^2), negative past r / sqrt(2), clamped to 0 in training
+        CUT_GAUSSIAN, // The Gaussian lowered to reach 0 at the radius
+        EPANECHNIKOV  // 1 - d^2 / r^2
+    };
 
     enum DistanceMetric {
         EUCLIDEAN, // Euclidean Distance, is a classic metric for many solutions
@@ -50,6 +72,19 @@ namespace som {
         MSE        // Mean-Squared Error, is a normalized version SSD
     };
     
+    // An OpenCL device as listed by SOM::getDevices()
+    struct DeviceInfo {
+        size_t index;                // Position in the list
+        std::string platform;
+        std::string name;
+        Device type;                 // CPU, GPU, or ALL_DEVICES for the other kinds
+        size_t computeUnits;
+        size_t globalMemorySize;     // Bytes
+        size_t maxAllocationSize;    // Bytes
+        bool unifiedMemory;          // Shares the host memory, the buffers are used in place
+        size_t preferredVectorWidth; // Floats
+    };
+    
     struct Cell {
         Cell(cl_float &center_, cl_float &corners_, cl_float &weights_, cl_float &distance_, cl_int &label_, cl_int &state_) :
         center(&center_), corners(&corners_), weights(&weights_), distance(&distance_), label(&label_), state(&state_) {}
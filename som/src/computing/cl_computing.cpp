@@ -0,0 +1,896 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+#include "cl_computing.hpp"
+#include "model.hpp"
+#include "neighbourhood.hpp"
+#include "weight_update_kernel.hpp"
+#include "bmu_reduction_kernel.hpp"
+#include "batch_update_kernel.hpp"
+#include "weight_distance_kernels.hpp"
+#include "devices.hpp"
+#include "runtime.hpp"
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Vectors are uploaded in tiles of about this size, so that the next tile uploads while one is computed
+    static const size_t STAGING_TILE_BYTES = 4 << 20;
+    
+    // Work-groups of the error sums, each writes a pair of partial sums per tile
+    static const size_t ERROR_GROUPS_COUNT = 64;
+}
+
+const size_t CLComputing::MAX_WORKERS_COUNT;
+
+CLComputing::CLComputing(Model &model, const Device deviceType, const WeightsLayout layout) :
+CLComputing(model, Devices::find(deviceType), 0, model.getNodesCount(), layout) {}
+
+CLComputing::CLComputing(Model &model, cl_device_id deviceId, const size_t nodesBegin, const size_t nodesEnd, const WeightsLayout layout) :
+Computing(model),
+deviceType_(CPU),
+layout_(layout),
+modelOutdated_(false),
+zeroCopy_(false),
+stepsQueued_(false),
+nodesBegin_(nodesBegin),
+nodesEnd_(nodesEnd),
+context_(nullptr),
+deviceId_(deviceId),
+commandQueue_(nullptr),
+transferQueue_(nullptr),
+inputVectorBuffer_(nullptr),
+pointsBuffer_(nullptr),
+weightsBuffer_(nullptr),
+weightDistancesBuffer_(nullptr),
+distancesAccumulatorBuffer_(nullptr),
+dataBuffer_(nullptr),
+dataBmuIndicesBuffer_(nullptr),
+errorPartialsBuffer_(nullptr),
+errorPartialsCapacity_(0),
+topKIndicesBuffer_(nullptr),
+topKDistancesBuffer_(nullptr),
+topKCapacity_(0),
+staging_(),
+stagingIndex_(0),
+stagingTileSize_(0),
+maxBatchSize_(0),
+pointDistances_(model.getNodesCount()),
+weightUpdateKernel_(nullptr),
+bmuReductionKernel_(nullptr),
+batchUpdateKernel_(nullptr) {
+    assert(deviceId_ && nodesBegin_ < nodesEnd_ && nodesEnd_ <= model_.getNodesCount());
+    
+    // The context and the programs are shared with the other models on the device, the queues are not,
+    // so finish() and the reads only wait on the work of this model
+    context_ = Runtime::shared().context(deviceId_);
+    clRetainContext(context_);
+    
+    commandQueue_ = clCreateCommandQueue(context_, deviceId_, 0, nullptr);
+    
+    // Uploads of the staging tiles, ordered against the kernels with events
+    transferQueue_ = clCreateCommandQueue(context_, deviceId_, 0, nullptr);
+    
+    cl_device_type type = CL_DEVICE_TYPE_CPU;
+    clGetDeviceInfo(deviceId_, CL_DEVICE_TYPE, sizeof(cl_device_type), &type, nullptr);
+    
+    deviceType_ = type & CL_DEVICE_TYPE_GPU ? GPU : CPU;
+    
+    if (layout_ == DEVICE_LAYOUT) {
+        layout_ = deviceType_ == GPU ? CHANNEL_MAJOR : NODE_MAJOR;
+    }
+    
+    // CPUs and integrated GPUs work on the Model arrays in place. The shards keep their own copies,
+    // the other shards write the Model arrays too.
+    cl_bool unifiedMemory = CL_FALSE;
+    clGetDeviceInfo(deviceId_, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unifiedMemory, nullptr);
+    zeroCopy_ = unifiedMemory == CL_TRUE && nodesEnd_ - nodesBegin_ == model_.getNodesCount();
+    
+    // Pinned host memory for the buffers that are written on every call
+    cl_mem_flags stagingFlags = zeroCopy_ ? CL_MEM_ALLOC_HOST_PTR : 0;
+    
+    weightUpdateKernel_ = new WeightUpdateKernel(context_, commandQueue_, deviceId_);
+    bmuReductionKernel_ = new BmuReductionKernel(context_, commandQueue_, deviceId_);
+    
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    
+    inputVectorBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE | stagingFlags, sizeof(cl_float) * channels, nullptr, nullptr);
+    
+    cl_float *points = &model_.getPoints();
+    pointsBuffer_ = clCreateBuffer(context_, CL_MEM_COPY_HOST_PTR, nodesCount * 2 * sizeof(cl_float), points, nullptr);
+    
+    if (sharesWeights()) {
+        weightsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, nodesCount * channels * sizeof(cl_float), &model_.getWeights(), nullptr);
+    } else {
+        weightsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, nodesCount * channels * sizeof(cl_float), nullptr, nullptr);
+        uploadWeights();
+    }
+    
+    cl_float *distances = &model_.getDistances();
+    cl_float *distancesAccumulator = &model_.getDistancesAccumulator();
+    
+    if (zeroCopy_) {
+        weightDistancesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, nodesCount * sizeof(cl_float), distances, nullptr);
+        distancesAccumulatorBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, nodesCount * sizeof(cl_float), distancesAccumulator, nullptr);
+    } else {
+        weightDistancesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, nodesCount * sizeof(cl_float), nullptr, nullptr);
+        distancesAccumulatorBuffer_ = clCreateBuffer(context_, CL_MEM_COPY_HOST_PTR, nodesCount * sizeof(cl_float), distancesAccumulator, nullptr);
+    }
+    
+    cl_ulong maxAllocSize = 0;
+    clGetDeviceInfo(deviceId_, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocSize, nullptr);
+    maxBatchSize_ = max((size_t)1, (size_t)(maxAllocSize / (channels * sizeof(cl_float))));
+    stagingTileSize_ = min(maxBatchSize_, max((size_t)1, STAGING_TILE_BYTES / (channels * sizeof(cl_float))));
+    
+    weightUpdateKernel_->connect(model_, inputVectorBuffer_, weightsBuffer_, pointsBuffer_, layout_);
+    bmuReductionKernel_->connect(model_, weightDistancesBuffer_, distancesAccumulatorBuffer_);
+    
+    setNodesRange(nodesBegin_, nodesEnd_);
+}
+
+CLComputing::~CLComputing() {
+    finish();
+    
+    delete weightUpdateKernel_;
+    delete bmuReductionKernel_;
+    delete batchUpdateKernel_;
+    
+    for (auto &kernel : weightDistanceKernels_) {
+        delete kernel.second;
+    }
+    
+    for (auto worker : workers_) {
+        releaseWorker(*worker);
+        delete worker;
+    }
+    
+    clReleaseMemObject(inputVectorBuffer_);
+    clReleaseMemObject(pointsBuffer_);
+    clReleaseMemObject(weightsBuffer_);
+    clReleaseMemObject(weightDistancesBuffer_);
+    clReleaseMemObject(distancesAccumulatorBuffer_);
+    
+    for (auto &slot : staging_) {
+        releaseSlot(slot);
+    }
+    
+    if (dataBuffer_) { clReleaseMemObject(dataBuffer_); }
+    if (dataBmuIndicesBuffer_) { clReleaseMemObject(dataBmuIndicesBuffer_); }
+    if (errorPartialsBuffer_) { clReleaseMemObject(errorPartialsBuffer_); }
+    if (topKIndicesBuffer_) { clReleaseMemObject(topKIndicesBuffer_); }
+    if (topKDistancesBuffer_) { clReleaseMemObject(topKDistancesBuffer_); }
+
+    clReleaseCommandQueue(transferQueue_);
+    clReleaseCommandQueue(commandQueue_);
+    clReleaseDevice(deviceId_);
+    clReleaseContext(context_);
+}
+
+bool CLComputing::isAvailable(const Device deviceType) {
+    return Devices::find(deviceType) != nullptr;
+}
+
+void CLComputing::setNodesRange(const size_t begin, const size_t end) {
+    assert(begin < end && end <= model_.getNodesCount());
+    assert(!zeroCopy_ || end - begin == model_.getNodesCount());
+    
+    finish();
+    
+    nodesBegin_ = begin;
+    nodesEnd_ = end;
+    
+    weightUpdateKernel_->setNodesRange(begin, end);
+    bmuReductionKernel_->setNodesRange(begin, end);
+    
+    for (auto &kernel : weightDistanceKernels_) {
+        kernel.second->setNodesRange(begin, end);
+    }
+    
+    if (batchUpdateKernel_) {
+        batchUpdateKernel_->setNodesRange(begin, end);
+    }
+    
+    for (auto worker : workers_) {
+        if (worker->weightDistanceKernel) {
+            worker->weightDistanceKernel->setNodesRange(begin, end);
+        }
+    }
+}
+
+#pragma mark - BMU
+
+size_t CLComputing::bmuIndex(const cl_float &inputVector, bool accumulateDistances, cl_float &distance) {
+    weightDistanceKernel()->compute(inputVector);
+    
+    if (accumulateDistances) {
+        modelOutdated_ = true;
+    }
+    
+    return bmuReductionKernel_->compute(accumulateDistances, distance);
+}
+
+void CLComputing::bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices) {
+    auto channels = model_.getChannelsCount();
+    auto kernel = weightDistanceKernel();
+    
+    const cl_float *data = &vectors;
+    vector<cl_uint> indices(count);
+    vector<cl_event> reads;
+    
+    // Only the reads are waited for, the uploads and kernels are chained with events
+    for (size_t offset = 0; offset < count; offset += stagingTileSize_) {
+        auto tileSize = min(count - offset, stagingTileSize_);
+        
+        cl_event uploaded, read;
+        auto &slot = stage(&data[offset * channels], nullptr, tileSize, &uploaded);
+        
+        kernel->computeBmuIndices(slot.vectorsBuffer, slot.bmuIndicesBuffer, tileSize, &uploaded, &slot.released);
+        clEnqueueReadBuffer(commandQueue_, slot.bmuIndicesBuffer, CL_FALSE, 0, tileSize * sizeof(cl_uint), &indices[offset], 0, nullptr, &read);
+        
+        clReleaseEvent(uploaded);
+        reads.push_back(read);
+    }
+    
+    if (!reads.empty()) {
+        clWaitForEvents((cl_uint)reads.size(), reads.data());
+    }
+    
+    for (auto &read : reads) {
+        clReleaseEvent(read);
+    }
+    
+    for (auto i = 0; i < count; i++) {
+        bmuIndices[i] = indices[i];
+    }
+}
+
+void CLComputing::topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances) {
+    auto channels = model_.getChannelsCount();
+    auto kernel = weightDistanceKernel();
+    
+    const cl_float *data = &vectors;
+    
+    if (k > WeightDistanceKernel::MAX_TOP_K) {
+        vector<size_t> order(nodesEnd_ - nodesBegin_);
+        auto sorted = min(k, order.size());
+        
+        for (auto i = 0; i < count; i++) {
+            kernel->compute(data[i * channels]);
+            cl_float *weightDistances = &this->weightDistances();
+            
+            iota(order.begin(), order.end(), nodesBegin_);
+            partial_sort(order.begin(), order.begin() + sorted, order.end(), [&](size_t a, size_t b) {
+                return weightDistances[a] < weightDistances[b] || (weightDistances[a] == weightDistances[b] && a < b);
+            });
+            
+            for (auto j = 0; j < k; j++) {
+                // A shard smaller than k pads its results like the device reduction
+                indices[i * k + j] = j < sorted ? order[j] : CL_UINT_MAX;
+                distances[i * k + j] = j < sorted ? weightDistances[order[j]] : FLT_MAX;
+            }
+        }
+        
+        return;
+    }
+    
+    // The results of a tile take about as much memory as its vectors
+    auto tileSize = max((size_t)1, stagingTileSize_ * channels / (k * 2));
+    tileSize = min(tileSize, stagingTileSize_);
+    
+    if (min(count, tileSize) * k > topKCapacity_) {
+        if (topKIndicesBuffer_) { clReleaseMemObject(topKIndicesBuffer_); }
+        if (topKDistancesBuffer_) { clReleaseMemObject(topKDistancesBuffer_); }
+        
+        topKCapacity_ = min(count, tileSize) * k;
+        topKIndicesBuffer_ = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, topKCapacity_ * sizeof(cl_uint), nullptr, nullptr);
+        topKDistancesBuffer_ = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, topKCapacity_ * sizeof(cl_float), nullptr, nullptr);
+    }
+    
+    vector<cl_uint> topIndices(count * k);
+    vector<cl_event> reads;
+    
+    // The next kernel on the in-order queue runs after the read of the previous tile results
+    for (size_t offset = 0; offset < count; offset += tileSize) {
+        auto size = min(count - offset, tileSize);
+        
+        cl_event uploaded, read;
+        auto &slot = stage(&data[offset * channels], nullptr, size, &uploaded);
+        
+        kernel->computeTopK(slot.vectorsBuffer, topKIndicesBuffer_, topKDistancesBuffer_, size, k, &uploaded, &slot.released);
+        clEnqueueReadBuffer(commandQueue_, topKIndicesBuffer_, CL_FALSE, 0, size * k * sizeof(cl_uint), &topIndices[offset * k], 0, nullptr, nullptr);
+        clEnqueueReadBuffer(commandQueue_, topKDistancesBuffer_, CL_FALSE, 0, size * k * sizeof(cl_float), &distances[offset * k], 0, nullptr, &read);
+        
+        clReleaseEvent(uploaded);
+        reads.push_back(read);
+    }
+    
+    if (!reads.empty()) {
+        clWaitForEvents((cl_uint)reads.size(), reads.data());
+    }
+    
+    for (auto &read : reads) {
+        clReleaseEvent(read);
+    }
+    
+    for (auto i = 0; i < count * k; i++) {
+        indices[i] = topIndices[i];
+    }
+}
+
+#pragma mark - Concurrent search
+
+void CLComputing::searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances) {
+    auto channels = model_.getChannelsCount();
+    auto &worker = checkoutWorker();
+    auto kernel = worker.weightDistanceKernel;
+    
+    const cl_float *data = &vectors;
+    vector<cl_uint> indices(count);
+    
+    for (size_t offset = 0; offset < count; offset += stagingTileSize_) {
+        auto tileSize = min(count - offset, stagingTileSize_);
+        
+        reserveWorker(worker, tileSize);
+        
+        clEnqueueWriteBuffer(worker.commandQueue, worker.vectorsBuffer, CL_FALSE, 0, tileSize * channels * sizeof(cl_float), &data[offset * channels], 0, nullptr, nullptr);
+        
+        // The nearest node of the top-k search comes with its distance
+        if (distances) {
+            kernel->computeTopK(worker.vectorsBuffer, worker.bmuIndicesBuffer, worker.distancesBuffer, tileSize, 1);
+            clEnqueueReadBuffer(worker.commandQueue, worker.distancesBuffer, CL_FALSE, 0, tileSize * sizeof(cl_float), &distances[offset], 0, nullptr, nullptr);
+        } else {
+            kernel->computeBmuIndices(worker.vectorsBuffer, worker.bmuIndicesBuffer, tileSize);
+        }
+        
+        clEnqueueReadBuffer(worker.commandQueue, worker.bmuIndicesBuffer, CL_TRUE, 0, tileSize * sizeof(cl_uint), &indices[offset], 0, nullptr, nullptr);
+    }
+    
+    returnWorker(worker);
+    
+    for (auto i = 0; i < count; i++) {
+        bmuIndices[i] = indices[i];
+    }
+}
+
+size_t CLComputing::getWorkersCount() {
+    unique_lock<mutex> lock(workersMutex_);
+    
+    return workers_.size();
+}
+
+CLComputing::Worker & CLComputing::checkoutWorker() {
+    unique_lock<mutex> lock(workersMutex_);
+    
+    // The queues of the workers aren't ordered after the model ones
+    if (stepsQueued_) {
+        finish();
+        stepsQueued_ = false;
+    }
+    
+    if (idleWorkers_.empty() && workers_.size() < MAX_WORKERS_COUNT) {
+        auto worker = new Worker();
+        worker->commandQueue = clCreateCommandQueue(context_, deviceId_, 0, nullptr);
+        
+        workers_.push_back(worker);
+        idleWorkers_.push_back(worker);
+    }
+    
+    workersCondition_.wait(lock, [this] { return !idleWorkers_.empty(); });
+    
+    auto &worker = *idleWorkers_.back();
+    idleWorkers_.pop_back();
+    
+    auto metric = model_.getMetric();
+    
+    if (!worker.weightDistanceKernel || worker.metric != metric) {
+        auto options = WeightDistanceKernel::buildOptions(model_.getChannelsCount(), layout_);
+        
+        delete worker.weightDistanceKernel;
+        
+        worker.weightDistanceKernel = WeightDistanceKernels::create(metric, context_, worker.commandQueue, deviceId_, options, deviceType_);
+        worker.weightDistanceKernel->connect(model_, inputVectorBuffer_, weightsBuffer_, weightDistancesBuffer_, pointsBuffer_);
+        worker.weightDistanceKernel->setNodesRange(nodesBegin_, nodesEnd_);
+        worker.metric = metric;
+    }
+    
+    return worker;
+}
+
+void CLComputing::returnWorker(Worker &worker) {
+    {
+        unique_lock<mutex> lock(workersMutex_);
+        idleWorkers_.push_back(&worker);
+    }
+    
+    workersCondition_.notify_one();
+}
+
+void CLComputing::reserveWorker(Worker &worker, const size_t count) {
+    if (count > worker.capacity) {
+        auto channels = model_.getChannelsCount();
+        
+        if (worker.vectorsBuffer) { clReleaseMemObject(worker.vectorsBuffer); }
+        if (worker.bmuIndicesBuffer) { clReleaseMemObject(worker.bmuIndicesBuffer); }
+        if (worker.distancesBuffer) { clReleaseMemObject(worker.distancesBuffer); }
+        
+        worker.vectorsBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY, count * channels * sizeof(cl_float), nullptr, nullptr);
+        worker.bmuIndicesBuffer = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, count * sizeof(cl_uint), nullptr, nullptr);
+        worker.distancesBuffer = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, count * sizeof(cl_float), nullptr, nullptr);
+        
+        worker.capacity = count;
+    }
+}
+
+void CLComputing::releaseWorker(Worker &worker) {
+    delete worker.weightDistanceKernel;
+    
+    if (worker.vectorsBuffer) { clReleaseMemObject(worker.vectorsBuffer); }
+    if (worker.bmuIndicesBuffer) { clReleaseMemObject(worker.bmuIndicesBuffer); }
+    if (worker.distancesBuffer) { clReleaseMemObject(worker.distancesBuffer); }
+    if (worker.commandQueue) { clReleaseCommandQueue(worker.commandQueue); }
+}
+
+#pragma mark - Staging
+
+CLComputing::StagingSlot & CLComputing::stage(const cl_float *vectors, const cl_float *schedule, const size_t count, cl_event *uploaded) {
+    auto channels = model_.getChannelsCount();
+    auto &slot = staging_[stagingIndex_];
+    
+    stagingIndex_ = (stagingIndex_ + 1) % 2;
+    
+    completeSlot(slot);
+    reserveSlot(slot, count);
+    
+    // The kernels of the previous tile in this slot have to be done reading it
+    cl_event released = slot.released;
+    cl_uint waitCount = released ? 1 : 0;
+    
+    slot.released = nullptr;
+    
+    if (schedule) {
+        clEnqueueWriteBuffer(transferQueue_, slot.scheduleBuffer, CL_FALSE, 0, count * 2 * sizeof(cl_float), schedule, waitCount, released ? &released : nullptr, nullptr);
+    }
+    
+    clEnqueueWriteBuffer(transferQueue_, slot.vectorsBuffer, CL_FALSE, 0, count * channels * sizeof(cl_float), vectors, waitCount, released ? &released : nullptr, uploaded);
+    clFlush(transferQueue_);
+    
+    if (released) {
+        clReleaseEvent(released);
+    }
+    
+    return slot;
+}
+
+void CLComputing::reserveSlot(StagingSlot &slot, const size_t count) {
+    if (count > slot.capacity) {
+        auto channels = model_.getChannelsCount();
+        
+        // The buffers are freed by OpenCL once the commands using them are done
+        releaseSlot(slot);
+        
+        cl_mem_flags flags = zeroCopy_ ? CL_MEM_ALLOC_HOST_PTR : 0;
+        
+        slot.vectorsBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | flags, count * channels * sizeof(cl_float), nullptr, nullptr);
+        slot.bmuIndicesBuffer = clCreateBuffer(context_, CL_MEM_READ_WRITE | flags, count * sizeof(cl_uint), nullptr, nullptr);
+        slot.scheduleBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | flags, count * 2 * sizeof(cl_float), nullptr, nullptr);
+        slot.errorsBuffer = clCreateBuffer(context_, CL_MEM_READ_WRITE, count * 2 * sizeof(cl_float), nullptr, nullptr);
+        
+        slot.capacity = count;
+    }
+}
+
+void CLComputing::completeSlot(StagingSlot &slot) {
+    if (!slot.indicesRead) {
+        return;
+    }
+    
+    clWaitForEvents(1, &slot.indicesRead);
+    clReleaseEvent(slot.indicesRead);
+    slot.indicesRead = nullptr;
+    
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    for (auto i = 0; i < slot.pendingCount; i++) {
+        activationStates[slot.indices[i]]++;
+    }
+    
+    slot.pendingCount = 0;
+}
+
+void CLComputing::releaseSlot(StagingSlot &slot) {
+    if (slot.vectorsBuffer) { clReleaseMemObject(slot.vectorsBuffer); }
+    if (slot.bmuIndicesBuffer) { clReleaseMemObject(slot.bmuIndicesBuffer); }
+    if (slot.scheduleBuffer) { clReleaseMemObject(slot.scheduleBuffer); }
+    if (slot.errorsBuffer) { clReleaseMemObject(slot.errorsBuffer); }
+    if (slot.released) { clReleaseEvent(slot.released); }
+    
+    slot.vectorsBuffer = nullptr;
+    slot.bmuIndicesBuffer = nullptr;
+    slot.scheduleBuffer = nullptr;
+    slot.errorsBuffer = nullptr;
+    slot.released = nullptr;
+    slot.capacity = 0;
+}
+
+void CLComputing::finish() {
+    for (auto &slot : staging_) {
+        completeSlot(slot);
+    }
+    
+    clFinish(transferQueue_);
+    clFinish(commandQueue_);
+}
+
+WeightDistanceKernel * CLComputing::weightDistanceKernel() {
+    auto metric = model_.getMetric();
+    auto &kernel = weightDistanceKernels_[metric];
+    
+    if (!kernel) {
+        auto options = WeightDistanceKernel::buildOptions(model_.getChannelsCount(), layout_);
+        
+        kernel = WeightDistanceKernels::create(metric, context_, commandQueue_, deviceId_, options, deviceType_);
+        kernel->connect(model_, inputVectorBuffer_, weightsBuffer_, weightDistancesBuffer_, pointsBuffer_);
+        kernel->setNodesRange(nodesBegin_, nodesEnd_);
+    }
+    
+    return kernel;
+}
+
+cl_float & CLComputing::weightDistances() {
+    cl_float *distances = &model_.getDistances();
+    
+    readNodes(weightDistancesBuffer_, sizeof(cl_float), distances, zeroCopy_);
+    
+    return distances[0];
+}
+
+#pragma mark - Training
+
+void CLComputing::adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius) {
+    if (!weightUpdateKernel_->isNeighbourhoodConnected()) {
+        weightUpdateKernel_->connect(model_.getNeighbourhood());
+    }
+    
+    weightUpdateKernel_->compute(bmuIndex, neighbourhoodRadius, learningRate, cutoffRadius, model_.getNeighbourhoodFunction());
+    
+    modelOutdated_ = true;
+    stepsQueued_ = true;
+}
+
+void CLComputing::adjustWeightsBatch(const double neighbourhoodRadius) {
+    auto channels = model_.getChannelsCount();
+    auto count = model_.getDataCount();
+    auto kernel = weightDistanceKernel();
+    
+    cl_float *data = &model_.getData();
+    
+    // The data set stays on the device between the epochs when it fits into a single allocation
+    if (count <= maxBatchSize_) {
+        reserveData();
+        
+        kernel->computeBmuIndices(dataBuffer_, dataBmuIndicesBuffer_, count);
+        batchUpdateKernel()->accumulate(dataBuffer_, dataBmuIndicesBuffer_, count);
+    } else {
+        // Otherwise it's streamed through the staging slots every epoch
+        for (size_t offset = 0; offset < count; offset += stagingTileSize_) {
+            auto tileSize = min(count - offset, stagingTileSize_);
+            
+            cl_event uploaded;
+            auto &slot = stage(&data[offset * channels], nullptr, tileSize, &uploaded);
+            
+            kernel->computeBmuIndices(slot.vectorsBuffer, slot.bmuIndicesBuffer, tileSize, &uploaded);
+            batchUpdateKernel()->accumulate(slot.vectorsBuffer, slot.bmuIndicesBuffer, tileSize, &slot.released);
+            
+            clReleaseEvent(uploaded);
+        }
+    }
+    
+    batchUpdateKernel()->compute(neighbourhoodRadius, model_.getNeighbourhoodFunction(), &model_.getActivationStates());
+    
+    modelOutdated_ = true;
+    stepsQueued_ = true;
+}
+
+void CLComputing::adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule) {
+    auto kernel = weightDistanceKernel();
+    
+    cl_event uploaded;
+    auto &slot = stage(&vectors, &schedule, count, &uploaded);
+    auto &previousSlot = staging_[stagingIndex_];
+    
+    kernel->computeBmuIndices(slot.vectorsBuffer, slot.bmuIndicesBuffer, count, &uploaded);
+    weightUpdateKernel_->computeMiniBatch(slot.vectorsBuffer, slot.bmuIndicesBuffer, slot.scheduleBuffer, count, model_.getNeighbourhoodFunction(), &slot.released);
+    
+    slot.indices.resize(count);
+    slot.pendingCount = count;
+    
+    clEnqueueReadBuffer(commandQueue_, slot.bmuIndicesBuffer, CL_FALSE, 0, count * sizeof(cl_uint), slot.indices.data(), 0, nullptr, &slot.indicesRead);
+    clFlush(commandQueue_);
+    clReleaseEvent(uploaded);
+    
+    // The host prepares the next step while this one runs, the previous step is done by then
+    completeSlot(previousSlot);
+    
+    modelOutdated_ = true;
+    stepsQueued_ = true;
+}
+
+void CLComputing::adjustWeightsBatch(const double neighbourhoodRadius, const cl_uint *bmuIndices) {
+    auto channels = model_.getChannelsCount();
+    auto count = model_.getDataCount();
+    
+    cl_float *data = &model_.getData();
+    
+    if (count <= maxBatchSize_) {
+        reserveData();
+        
+        clEnqueueWriteBuffer(commandQueue_, dataBmuIndicesBuffer_, CL_TRUE, 0, count * sizeof(cl_uint), bmuIndices, 0, nullptr, nullptr);
+        batchUpdateKernel()->accumulate(dataBuffer_, dataBmuIndicesBuffer_, count);
+    } else {
+        for (size_t offset = 0; offset < count; offset += stagingTileSize_) {
+            auto tileSize = min(count - offset, stagingTileSize_);
+            
+            cl_event uploaded;
+            auto &slot = stage(&data[offset * channels], nullptr, tileSize, &uploaded);
+            
+            clEnqueueWriteBuffer(commandQueue_, slot.bmuIndicesBuffer, CL_TRUE, 0, tileSize * sizeof(cl_uint), &bmuIndices[offset], 1, &uploaded, nullptr);
+            batchUpdateKernel()->accumulate(slot.vectorsBuffer, slot.bmuIndicesBuffer, tileSize, &slot.released);
+            
+            clReleaseEvent(uploaded);
+        }
+    }
+    
+    batchUpdateKernel()->compute(neighbourhoodRadius, model_.getNeighbourhoodFunction(), nullptr);
+    
+    modelOutdated_ = true;
+    stepsQueued_ = true;
+}
+
+void CLComputing::adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule, const cl_uint *bmuIndices) {
+    cl_event uploaded;
+    auto &slot = stage(&vectors, &schedule, count, &uploaded);
+    
+    clEnqueueWriteBuffer(commandQueue_, slot.bmuIndicesBuffer, CL_TRUE, 0, count * sizeof(cl_uint), bmuIndices, 1, &uploaded, nullptr);
+    weightUpdateKernel_->computeMiniBatch(slot.vectorsBuffer, slot.bmuIndicesBuffer, slot.scheduleBuffer, count, model_.getNeighbourhoodFunction(), &slot.released);
+    
+    clFlush(commandQueue_);
+    clReleaseEvent(uploaded);
+    
+    modelOutdated_ = true;
+    stepsQueued_ = true;
+}
+
+void CLComputing::reserveData() {
+    if (dataBuffer_) {
+        return;
+    }
+    
+    auto channels = model_.getChannelsCount();
+    auto count = model_.getDataCount();
+    
+    cl_float *data = &model_.getData();
+    
+    dataBmuIndicesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, count * sizeof(cl_uint), nullptr, nullptr);
+    
+    if (zeroCopy_) {
+        dataBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, count * channels * sizeof(cl_float), data, nullptr);
+    } else {
+        dataBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, count * channels * sizeof(cl_float), nullptr, nullptr);
+        clEnqueueWriteBuffer(commandQueue_, dataBuffer_, CL_FALSE, 0, count * channels * sizeof(cl_float), data, 0, nullptr, nullptr);
+    }
+}
+
+BatchUpdateKernel * CLComputing::batchUpdateKernel() {
+    if (!batchUpdateKernel_) {
+        batchUpdateKernel_ = new BatchUpdateKernel(context_, commandQueue_, deviceId_);
+        batchUpdateKernel_->connect(model_, weightsBuffer_, pointsBuffer_, layout_);
+        batchUpdateKernel_->setNodesRange(nodesBegin_, nodesEnd_);
+    }
+    
+    return batchUpdateKernel_;
+}
+
+#pragma mark - Error
+
+void CLComputing::errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum) {
+    auto channels = model_.getChannelsCount();
+    auto kernel = weightDistanceKernel();
+    
+    const cl_float *data = &vectors;
+    cl_float maxAdjacentDistance = 2 * model_.getNeighbourhood().getSquaredSpacing();
+    
+    auto tilesCount = (count + stagingTileSize_ - 1) / stagingTileSize_;
+    auto partialsCount = tilesCount * ERROR_GROUPS_COUNT;
+    
+    distancesSum = 0;
+    topographicErrorsSum = 0;
+    
+    if (partialsCount == 0) {
+        return;
+    }
+    
+    if (partialsCount > errorPartialsCapacity_) {
+        if (errorPartialsBuffer_) { clReleaseMemObject(errorPartialsBuffer_); }
+        
+        errorPartialsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, partialsCount * 2 * sizeof(cl_float), nullptr, nullptr);
+        errorPartialsCapacity_ = partialsCount;
+    }
+    
+    // Every tile writes partials of its own, summing them on the device in float would lose the small distances
+    // of the late tiles on large data sets
+    for (size_t offset = 0; offset < count; offset += stagingTileSize_) {
+        auto tileSize = min(count - offset, stagingTileSize_);
+        
+        cl_event uploaded;
+        auto &slot = stage(&data[offset * channels], nullptr, tileSize, &uploaded);
+        
+        kernel->computeErrors(slot.vectorsBuffer, slot.errorsBuffer, tileSize, maxAdjacentDistance, &uploaded);
+        kernel->sumErrors(slot.errorsBuffer, tileSize, errorPartialsBuffer_, offset / stagingTileSize_ * ERROR_GROUPS_COUNT, ERROR_GROUPS_COUNT, &slot.released);
+        
+        clReleaseEvent(uploaded);
+    }
+    
+    vector<cl_float> partials(partialsCount * 2);
+    clEnqueueReadBuffer(commandQueue_, errorPartialsBuffer_, CL_TRUE, 0, partials.size() * sizeof(cl_float), partials.data(), 0, nullptr, nullptr);
+    
+    for (auto i = 0; i < partialsCount; i++) {
+        distancesSum += partials[i * 2];
+        topographicErrorsSum += partials[i * 2 + 1];
+    }
+}
+
+#pragma mark - Topological distances
+
+cl_float & CLComputing::pointDistances(const size_t index) {
+    model_.getNeighbourhood().squaredDistances(index, pointDistances_.data());
+    
+    return pointDistances_[0];
+}
+
+#pragma mark - Synchronization
+
+void CLComputing::readModel() {
+    finish();
+    
+    if (modelOutdated_) {
+        downloadWeights();
+        readNodes(distancesAccumulatorBuffer_, sizeof(cl_float), &model_.getDistancesAccumulator(), zeroCopy_);
+        
+        modelOutdated_ = false;
+    }
+}
+
+void CLComputing::writeModel() {
+    auto nodesCount = model_.getNodesCount();
+    
+    finish();
+    
+    uploadWeights();
+    writeBuffer(distancesAccumulatorBuffer_, nodesCount * sizeof(cl_float), &model_.getDistancesAccumulator(), zeroCopy_);
+    
+    stepsQueued_ = true;
+    
+    // The data may have changed, it's uploaded again by the next batch step
+    if (dataBuffer_) {
+        clReleaseMemObject(dataBuffer_);
+        clReleaseMemObject(dataBmuIndicesBuffer_);
+        
+        dataBuffer_ = nullptr;
+        dataBmuIndicesBuffer_ = nullptr;
+    }
+    
+    modelOutdated_ = false;
+}
+
+void CLComputing::uploadWeights() {
+    auto nodesCount = model_.getNodesCount();
+    auto channels = model_.getChannelsCount();
+    
+    cl_float *weights = &model_.getWeights();
+    
+    if (layout_ != CHANNEL_MAJOR) {
+        writeBuffer(weightsBuffer_, nodesCount * channels * sizeof(cl_float), weights, sharesWeights());
+        
+        return;
+    }
+    
+    vector<cl_float> transposed(nodesCount * channels);
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        for (auto j = 0; j < channels; j++) {
+            transposed[j * nodesCount + i] = weights[i * channels + j];
+        }
+    }
+    
+    clEnqueueWriteBuffer(commandQueue_, weightsBuffer_, CL_TRUE, 0, nodesCount * channels * sizeof(cl_float), transposed.data(), 0, nullptr, nullptr);
+}
+
+void CLComputing::downloadWeights() {
+    auto nodesCount = model_.getNodesCount();
+    auto channels = model_.getChannelsCount();
+    
+    cl_float *weights = &model_.getWeights();
+    
+    if (layout_ != CHANNEL_MAJOR) {
+        readNodes(weightsBuffer_, channels * sizeof(cl_float), weights, sharesWeights());
+        
+        return;
+    }
+    
+    vector<cl_float> transposed(nodesCount * channels);
+    
+    clEnqueueReadBuffer(commandQueue_, weightsBuffer_, CL_TRUE, 0, nodesCount * channels * sizeof(cl_float), transposed.data(), 0, nullptr, nullptr);
+    
+    for (auto i = nodesBegin_; i < nodesEnd_; i++) {
+        for (auto j = 0; j < channels; j++) {
+            weights[i * channels + j] = transposed[j * nodesCount + i];
+        }
+    }
+}
+
+void CLComputing::readBuffer(const cl_mem &buffer, const size_t size, void *host, const bool inPlace) {
+    if (!inPlace) {
+        clEnqueueReadBuffer(commandQueue_, buffer, CL_TRUE, 0, size, host, 0, nullptr, nullptr);
+        
+        return;
+    }
+    
+    // Mapping a CL_MEM_USE_HOST_PTR buffer makes the device results visible in the host array, without a copy on unified memory
+    void *mapped = clEnqueueMapBuffer(commandQueue_, buffer, CL_TRUE, CL_MAP_READ, 0, size, 0, nullptr, nullptr, nullptr);
+    
+    assert(mapped == host);
+    
+    clEnqueueUnmapMemObject(commandQueue_, buffer, mapped, 0, nullptr, nullptr);
+    clFinish(commandQueue_);
+}
+
+void CLComputing::readNodes(const cl_mem &buffer, const size_t elementSize, void *host, const bool inPlace) {
+    if (inPlace) {
+        readBuffer(buffer, model_.getNodesCount() * elementSize, host, true);
+        
+        return;
+    }
+    
+    auto offset = nodesBegin_ * elementSize;
+    
+    clEnqueueReadBuffer(commandQueue_, buffer, CL_TRUE, offset, (nodesEnd_ - nodesBegin_) * elementSize, (char *)host + offset, 0, nullptr, nullptr);
+}
+
+void CLComputing::writeBuffer(const cl_mem &buffer, const size_t size, const void *host, const bool inPlace) {
+    if (!inPlace) {
+        clEnqueueWriteBuffer(commandQueue_, buffer, CL_TRUE, 0, size, host, 0, nullptr, nullptr);
+        
+        return;
+    }
+    
+    // The host array already holds the values, the map invalidates the device view and the unmap publishes them
+    void *mapped = clEnqueueMapBuffer(commandQueue_, buffer, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, size, 0, nullptr, nullptr, nullptr);
+    
+    assert(mapped == host);
+    
+    clEnqueueUnmapMemObject(commandQueue_, buffer, mapped, 0, nullptr, nullptr);
+    clFinish(commandQueue_);
+}
+
+bool CLComputing::sharesWeights() const {
+    return zeroCopy_ && layout_ != CHANNEL_MAJOR;
+}
+
+WeightsLayout CLComputing::getWeightsLayout() const {
+    return layout_;
+}
@@ -0,0 +1,208 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "devices.hpp"
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Searches timed per backend by fastest(), after one that builds the kernels
+    static const size_t BENCHMARK_SEARCHES = 16;
+    
+    static cl_device_type clDeviceType(const Device deviceType) {
+        switch (deviceType) {
+            case CPU: return CL_DEVICE_TYPE_CPU;
+            case GPU: return CL_DEVICE_TYPE_GPU;
+            default:  return CL_DEVICE_TYPE_ALL;
+        }
+    }
+    
+    static string deviceString(const cl_device_id &deviceId, const cl_device_info param) {
+        size_t size = 0;
+        clGetDeviceInfo(deviceId, param, 0, nullptr, &size);
+        
+        string value(size, '\0');
+        clGetDeviceInfo(deviceId, param, size, &value[0], nullptr);
+        
+        // Without the terminating zero
+        return value.c_str();
+    }
+}
+
+vector<cl_device_id> Devices::ids() {
+    vector<cl_device_id> devices;
+    cl_uint platformsCount = 0;
+    
+    if (clGetPlatformIDs(0, nullptr, &platformsCount) != CL_SUCCESS || platformsCount == 0) {
+        return devices;
+    }
+    
+    vector<cl_platform_id> platforms(platformsCount);
+    clGetPlatformIDs(platformsCount, platforms.data(), nullptr);
+    
+    // A platform without devices reports an error, the others are still listed
+    for (auto &platform : platforms) {
+        cl_uint devicesCount = 0;
+        
+        if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, nullptr, &devicesCount) != CL_SUCCESS || devicesCount == 0) {
+            continue;
+        }
+        
+        vector<cl_device_id> platformDevices(devicesCount);
+        clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, devicesCount, platformDevices.data(), nullptr);
+        
+        devices.insert(devices.end(), platformDevices.begin(), platformDevices.end());
+    }
+    
+    return devices;
+}
+
+vector<DeviceInfo> Devices::list() {
+    vector<DeviceInfo> devices;
+    
+    for (auto &deviceId : ids()) {
+        devices.push_back(info(deviceId, devices.size()));
+    }
+    
+    return devices;
+}
+
+DeviceInfo Devices::info(const cl_device_id &deviceId, const size_t index) {
+    DeviceInfo info;
+    
+    cl_platform_id platform = nullptr;
+    cl_device_type type = CL_DEVICE_TYPE_DEFAULT;
+    cl_uint computeUnits = 0, vectorWidth = 0;
+    cl_ulong globalMemorySize = 0, maxAllocationSize = 0;
+    cl_bool unifiedMemory = CL_FALSE;
+    
+    clGetDeviceInfo(deviceId, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_TYPE, sizeof(cl_device_type), &type, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, sizeof(cl_uint), &vectorWidth, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMemorySize, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocationSize, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unifiedMemory, nullptr);
+    
+    size_t size = 0;
+    clGetPlatformInfo(platform, CL_PLATFORM_NAME, 0, nullptr, &size);
+    
+    string platformName(size, '\0');
+    clGetPlatformInfo(platform, CL_PLATFORM_NAME, size, &platformName[0], nullptr);
+    
+    info.index = index;
+    info.platform = platformName.c_str();
+    info.name = deviceString(deviceId, CL_DEVICE_NAME);
+    info.type = type & CL_DEVICE_TYPE_GPU ? GPU : type & CL_DEVICE_TYPE_CPU ? CPU : ALL_DEVICES;
+    info.computeUnits = computeUnits;
+    info.globalMemorySize = (size_t)globalMemorySize;
+    info.maxAllocationSize = (size_t)maxAllocationSize;
+    info.unifiedMemory = unifiedMemory == CL_TRUE;
+    info.preferredVectorWidth = vectorWidth;
+    
+    return info;
+}
+
+cl_device_id Devices::find(const Device deviceType) {
+    cl_uint platformsCount = 0;
+    
+    if (clGetPlatformIDs(0, nullptr, &platformsCount) != CL_SUCCESS || platformsCount == 0) {
+        return nullptr;
+    }
+    
+    vector<cl_platform_id> platforms(platformsCount);
+    clGetPlatformIDs(platformsCount, platforms.data(), nullptr);
+    
+    // The first platform may lack the type when several drivers are installed
+    for (auto &platform : platforms) {
+        cl_device_id deviceId = nullptr;
+        cl_uint devicesCount = 0;
+        
+        if (clGetDeviceIDs(platform, clDeviceType(deviceType), 1, &deviceId, &devicesCount) == CL_SUCCESS && devicesCount > 0) {
+            return deviceId;
+        }
+    }
+    
+    return nullptr;
+}
+
+cl_device_id Devices::find(const string &name) {
+    for (auto &deviceId : ids()) {
+        if (deviceString(deviceId, CL_DEVICE_NAME).find(name) != string::npos) {
+            return deviceId;
+        }
+    }
+    
+    return nullptr;
+}
+
+size_t Devices::fastest(const size_t nodesCount, const size_t channels) {
+    auto cols = max((size_t)1, (size_t)ceil(sqrt((double)nodesCount)));
+    auto rows = (nodesCount + cols - 1) / cols;
+    
+    // The same map for every backend, without touching the random sequence of the caller
+    minstd_rand generator(1);
+    uniform_real_distribution<cl_float> distribution(0, 1);
+    
+    vector<vector<cl_float>> data(BENCHMARK_SEARCHES, vector<cl_float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = distribution(generator);
+        }
+    }
+    
+    Model model(cols, rows, channels, 1);
+    model.prepare(data, NO_NORM, RANDOM_FROM_DATA);
+    
+    cl_float *vectors = &model.getData();
+    
+    auto searchTime = [&](Computing &computing) {
+        computing.bmuIndex(vectors[0], false);
+        
+        auto start = chrono::steady_clock::now();
+        
+        for (auto i = 0; i < BENCHMARK_SEARCHES; i++) {
+            computing.bmuIndex(vectors[i * channels], false);
+        }
+        
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        
+        return elapsed.count();
+    };
+    
+    NativeComputing nativeComputing(model);
+    
+    auto fastestIndex = SIZE_MAX;
+    auto fastestTime = searchTime(nativeComputing);
+    auto devices = ids();
+    
+    for (auto i = 0; i < devices.size(); i++) {
+        CLComputing computing(model, devices[i], 0, model.getNodesCount());
+        auto time = searchTime(computing);
+        
+        if (time < fastestTime) {
+            fastestIndex = i;
+            fastestTime = time;
+        }
+    }
+    
+    return fastestIndex;
+}
@@ -0,0 +1,173 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "batch_update_kernel.hpp"
+#include "weight_update_kernel.hpp"
+#include "model.hpp"
+#include <vector>
+
+using namespace std;
+using namespace som;
+
+BatchUpdateKernel::BatchUpdateKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
+Kernel(WeightUpdateKernel::neighbourhoodFunctionsCode +
+       "void atomicAddFloat(volatile __global float *address, float value)"
+       "{"
+       "    unsigned int expected, current = as_uint(*address);"
+       ""
+       "    do {"
+       "        expected = current;"
+       "        current = atomic_cmpxchg((volatile __global unsigned int *)address, expected, as_uint(as_float(expected) + value));"
+       "    } while (current != expected);"
+       "}"
+       ""
+       "__kernel void accumulateClusters(__global float *inputVectors, __global unsigned int *bmuIndices, unsigned int vecSize,"
+       "                                 __global float *clusterSums, __global unsigned int *clusterCounts)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    unsigned int bmu = bmuIndices[id];"
+       ""
+       "    atomic_inc(&clusterCounts[bmu]);"
+       ""
+       "    for (int i = 0; i < vecSize; i++) {"
+       "        atomicAddFloat(&clusterSums[bmu * vecSize + i], inputVectors[id * vecSize + i]);"
+       "    }"
+       "}"
+       ""
+       "__kernel void updateWeightsBatch(__global float *weights, __global float *points, __global float *clusterSums, __global unsigned int *clusterCounts,"
+       "                                 unsigned int vecSize, unsigned int nodesCount, float neighbourhoodRadius, unsigned int nodeStride, unsigned int channelStride,"
+       "                                 int function)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    float x = points[id * 2];"
+       "    float y = points[id * 2 + 1];"
+       "    float squareNeighbourhood = neighbourhoodRadius * neighbourhoodRadius;"
+       ""
+       "    float influenceSum = 0.0;"
+       ""
+       "    for (int k = 0; k < nodesCount; k++) {"
+       "        float distance = (points[k * 2] - x) * (points[k * 2] - x) + (points[k * 2 + 1] - y) * (points[k * 2 + 1] - y);"
+       ""
+       "        if (clusterCounts[k] > 0 && distance <= squareNeighbourhood) {"
+       "            influenceSum += fmax(influence(distance, squareNeighbourhood, function), 0.0f) * clusterCounts[k];"
+       "        }"
+       "    }"
+       ""
+       "    if (influenceSum == 0.0) {"
+       "        return;"
+       "    }"
+       ""
+       "    for (int i = 0; i < vecSize; i++) {"
+       "        weights[id * nodeStride + i * channelStride] = 0.0;"
+       "    }"
+       ""
+       "    for (int k = 0; k < nodesCount; k++) {"
+       "        float distance = (points[k * 2] - x) * (points[k * 2] - x) + (points[k * 2 + 1] - y) * (points[k * 2 + 1] - y);"
+       ""
+       "        if (clusterCounts[k] > 0 && distance <= squareNeighbourhood) {"
+       "            float nodeInfluence = fmax(influence(distance, squareNeighbourhood, function), 0.0f) / influenceSum;"
+       ""
+       "            for (int i = 0; i < vecSize; i++) {"
+       "                weights[id * nodeStride + i * channelStride] += nodeInfluence * clusterSums[k * vecSize + i];"
+       "            }"
+       "        }"
+       "    }"
+       "}", "accumulateClusters", context, commandQueue, deviceId),
+updateKernel_(nullptr),
+clusterSumsBuffer_(nullptr),
+clusterCountsBuffer_(nullptr) {
+    updateKernel_ = clCreateKernel(program_, "updateWeightsBatch", nullptr);
+}
+
+BatchUpdateKernel::~BatchUpdateKernel() {
+    clReleaseKernel(updateKernel_);
+    
+    clReleaseMemObject(clusterSumsBuffer_);
+    clReleaseMemObject(clusterCountsBuffer_);
+}
+
+void BatchUpdateKernel::connect(const Model &model, const cl_mem &weightsBuffer, const cl_mem &pointsBuffer, const WeightsLayout layout) {
+    weightsBuffer_ = weightsBuffer;
+    pointsBuffer_ = pointsBuffer;
+    
+    channels_ = (cl_uint)model.getChannelsCount();
+    nodesCount_ = (cl_uint)model.getNodesCount();
+    
+    clusterSumsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, nodesCount_ * channels_ * sizeof(cl_float), nullptr, nullptr);
+    clusterCountsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, nodesCount_ * sizeof(cl_uint), nullptr, nullptr);
+    
+    clSetKernelArg(kernel_, 2, sizeof(cl_uint), &channels_);
+    clSetKernelArg(kernel_, 3, sizeof(cl_mem), &clusterSumsBuffer_);
+    clSetKernelArg(kernel_, 4, sizeof(cl_mem), &clusterCountsBuffer_);
+    
+    clSetKernelArg(updateKernel_, 0, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(updateKernel_, 1, sizeof(cl_mem), &pointsBuffer_);
+    clSetKernelArg(updateKernel_, 2, sizeof(cl_mem), &clusterSumsBuffer_);
+    clSetKernelArg(updateKernel_, 3, sizeof(cl_mem), &clusterCountsBuffer_);
+    clSetKernelArg(updateKernel_, 4, sizeof(cl_uint), &channels_);
+    clSetKernelArg(updateKernel_, 5, sizeof(cl_uint), &nodesCount_);
+    
+    cl_uint nodeStride = layout == CHANNEL_MAJOR ? 1 : channels_;
+    cl_uint channelStride = layout == CHANNEL_MAJOR ? nodesCount_ : 1;
+    
+    clSetKernelArg(updateKernel_, 7, sizeof(cl_uint), &nodeStride);
+    clSetKernelArg(updateKernel_, 8, sizeof(cl_uint), &channelStride);
+    
+    setNodesRange(0, nodesCount_);
+    
+    reset();
+}
+
+void BatchUpdateKernel::setNodesRange(const size_t begin, const size_t end) {
+    globalWorkOffset_[0] = begin;
+    globalWorkSize_[0] = end - begin;
+}
+
+void BatchUpdateKernel::accumulate(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count, cl_event *event) {
+    size_t globalWorkSize[1] = {count};
+    
+    clSetKernelArg(kernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(kernel_, 1, sizeof(cl_mem), &bmuIndicesBuffer);
+    
+    clEnqueueNDRangeKernel(commandQueue_, kernel_, 1, nullptr, globalWorkSize, nullptr, 0, nullptr, event);
+}
+
+void BatchUpdateKernel::compute(const double neighbourhoodRadius, const NeighbourhoodFunction function, cl_int *activationStates) {
+    cl_float clNeighbourhoodRadius = (cl_float)neighbourhoodRadius;
+    cl_int clFunction = function;
+    
+    clSetKernelArg(updateKernel_, 6, sizeof(cl_float), &clNeighbourhoodRadius);
+    clSetKernelArg(updateKernel_, 9, sizeof(cl_int), &clFunction);
+    
+    clEnqueueNDRangeKernel(commandQueue_, updateKernel_, 1, globalWorkOffset_, globalWorkSize_, nullptr, 0, nullptr, nullptr);
+    
+    if (activationStates) {
+        vector<cl_uint> counts(nodesCount_);
+        clEnqueueReadBuffer(commandQueue_, clusterCountsBuffer_, CL_TRUE, 0, nodesCount_ * sizeof(cl_uint), counts.data(), 0, nullptr, nullptr);
+        
+        for (auto i = 0; i < nodesCount_; i++) {
+            activationStates[i] += counts[i];
+        }
+    }
+    
+    reset();
+}
+
+void BatchUpdateKernel::reset() {
+    cl_float zero = 0;
+    cl_uint zeroCount = 0;
+    
+    clEnqueueFillBuffer(commandQueue_, clusterSumsBuffer_, &zero, sizeof(cl_float), 0, nodesCount_ * channels_ * sizeof(cl_float), 0, nullptr, nullptr);
+    clEnqueueFillBuffer(commandQueue_, clusterCountsBuffer_, &zeroCount, sizeof(cl_uint), 0, nodesCount_ * sizeof(cl_uint), 0, nullptr, nullptr);
+}
@@ -0,0 +1,191 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "bmu_reduction_kernel.hpp"
+#include "model.hpp"
+#include <cstring>
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    static const size_t MAX_LOCAL_WORK_SIZE = 256;
+}
+
+const string BmuReductionKernel::localReductionCode =
+"void reduceLocal(__local float *localDistances, __local unsigned int *localIndices, float distance, unsigned int index)"
+"{"
+"    int localId = get_local_id(0);"
+""
+"    localDistances[localId] = distance;"
+"    localIndices[localId] = index;"
+""
+"    barrier(CLK_LOCAL_MEM_FENCE);"
+""
+"    for (int offset = get_local_size(0) / 2; offset > 0; offset /= 2) {"
+"        if (localId < offset) {"
+"            float otherDistance = localDistances[localId + offset];"
+"            unsigned int otherIndex = localIndices[localId + offset];"
+""
+"            if (otherDistance < localDistances[localId] || (otherDistance == localDistances[localId] && otherIndex < localIndices[localId])) {"
+"                localDistances[localId] = otherDistance;"
+"                localIndices[localId] = otherIndex;"
+"            }"
+"        }"
+""
+"        barrier(CLK_LOCAL_MEM_FENCE);"
+"    }"
+"}";
+
+BmuReductionKernel::BmuReductionKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
+Kernel(localReductionCode +
+       "__kernel void reduceDistances(__global float *distances, __global float *accumulator, unsigned int count, unsigned int accumulate,"
+       "                              __global float *partialDistances, __global unsigned int *partialIndices,"
+       "                              __local float *localDistances, __local unsigned int *localIndices)"
+       "{"
+       "    float lowestDistance = FLT_MAX;"
+       "    unsigned int index = UINT_MAX;"
+       ""
+       "    for (unsigned int i = get_global_id(0); i < count; i += get_global_size(0)) {"
+       "        float distance = distances[i];"
+       ""
+       "        if (accumulate && distance > 0.0) {"
+       "            accumulator[i] += distance;"
+       "        }"
+       ""
+       "        if (distance < lowestDistance) {"
+       "            lowestDistance = distance;"
+       "            index = i;"
+       "        }"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    if (get_local_id(0) == 0) {"
+       "        partialDistances[get_group_id(0)] = localDistances[0];"
+       "        partialIndices[get_group_id(0)] = localIndices[0];"
+       "    }"
+       "}"
+       ""
+       "__kernel void reducePartials(__global float *partialDistances, __global unsigned int *partialIndices, unsigned int count,"
+       "                             __global unsigned int *result,"
+       "                             __local float *localDistances, __local unsigned int *localIndices)"
+       "{"
+       "    float lowestDistance = FLT_MAX;"
+       "    unsigned int index = UINT_MAX;"
+       ""
+       "    for (unsigned int i = get_local_id(0); i < count; i += get_local_size(0)) {"
+       "        float distance = partialDistances[i];"
+       ""
+       "        if (distance < lowestDistance || (distance == lowestDistance && partialIndices[i] < index)) {"
+       "            lowestDistance = distance;"
+       "            index = partialIndices[i];"
+       "        }"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    if (get_local_id(0) == 0) {"
+       "        result[0] = localIndices[0];"
+       "        result[1] = as_uint(localDistances[0]);"
+       "    }"
+       "}", "reduceDistances", context, commandQueue, deviceId),
+partialsKernel_(nullptr),
+partialDistancesBuffer_(nullptr),
+partialIndicesBuffer_(nullptr),
+resultBuffer_(nullptr) {
+    partialsKernel_ = clCreateKernel(program_, "reducePartials", nullptr);
+    
+    localWorkSize_[0] = localWorkSize(kernel_, deviceId);
+}
+
+BmuReductionKernel::~BmuReductionKernel() {
+    clReleaseKernel(partialsKernel_);
+    
+    clReleaseMemObject(partialDistancesBuffer_);
+    clReleaseMemObject(partialIndicesBuffer_);
+    clReleaseMemObject(resultBuffer_);
+}
+
+size_t BmuReductionKernel::localWorkSize(const cl_kernel &kernel, const cl_device_id &deviceId) {
+    size_t kernelWorkGroupSize = 1;
+    clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &kernelWorkGroupSize, nullptr);
+    
+    // The tree reduction needs a power of two work-group size
+    size_t size = 1;
+    while (size * 2 <= min(kernelWorkGroupSize, MAX_LOCAL_WORK_SIZE)) {
+        size *= 2;
+    }
+    
+    return size;
+}
+
+void BmuReductionKernel::connect(const Model &model, const cl_mem &distancesBuffer, const cl_mem &accumulatorBuffer) {
+    distancesBuffer_ = distancesBuffer;
+    accumulatorBuffer_ = accumulatorBuffer;
+    
+    size_t nodesCount = model.getNodesCount();
+    
+    // Sized for the whole map, so the range can change without new buffers
+    size_t groupsCount = (nodesCount + localWorkSize_[0] - 1) / localWorkSize_[0];
+    groupsCount = min(groupsCount, localWorkSize_[0]);
+    
+    partialDistancesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, groupsCount * sizeof(cl_float), nullptr, nullptr);
+    partialIndicesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, groupsCount * sizeof(cl_uint), nullptr, nullptr);
+    resultBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, 2 * sizeof(cl_uint), nullptr, nullptr);
+    
+    clSetKernelArg(kernel_, 0, sizeof(cl_mem), &distancesBuffer_);
+    clSetKernelArg(kernel_, 1, sizeof(cl_mem), &accumulatorBuffer_);
+    clSetKernelArg(kernel_, 4, sizeof(cl_mem), &partialDistancesBuffer_);
+    clSetKernelArg(kernel_, 5, sizeof(cl_mem), &partialIndicesBuffer_);
+    clSetKernelArg(kernel_, 6, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(kernel_, 7, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    
+    clSetKernelArg(partialsKernel_, 0, sizeof(cl_mem), &partialDistancesBuffer_);
+    clSetKernelArg(partialsKernel_, 1, sizeof(cl_mem), &partialIndicesBuffer_);
+    clSetKernelArg(partialsKernel_, 3, sizeof(cl_mem), &resultBuffer_);
+    clSetKernelArg(partialsKernel_, 4, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(partialsKernel_, 5, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    
+    setNodesRange(0, nodesCount);
+}
+
+void BmuReductionKernel::setNodesRange(const size_t begin, const size_t end) {
+    size_t groupsCount = (end - begin + localWorkSize_[0] - 1) / localWorkSize_[0];
+    groupsCount = max(min(groupsCount, localWorkSize_[0]), (size_t)1);
+    
+    // The work-items walk the nodes from the offset up to the end of the range
+    cl_uint nodesEnd = (cl_uint)end;
+    cl_uint partialsCount = (cl_uint)groupsCount;
+    
+    clSetKernelArg(kernel_, 2, sizeof(cl_uint), &nodesEnd);
+    clSetKernelArg(partialsKernel_, 2, sizeof(cl_uint), &partialsCount);
+    
+    globalWorkOffset_[0] = begin;
+    globalWorkSize_[0] = groupsCount * localWorkSize_[0];
+}
+
+size_t BmuReductionKernel::compute(bool accumulateDistances, cl_float &distance) {
+    cl_uint accumulate = accumulateDistances ? 1 : 0;
+    cl_uint result[2];
+    
+    clSetKernelArg(kernel_, 3, sizeof(cl_uint), &accumulate);
+    
+    clEnqueueNDRangeKernel(commandQueue_, kernel_, 1, globalWorkOffset_, globalWorkSize_, localWorkSize_, 0, nullptr, nullptr);
+    clEnqueueNDRangeKernel(commandQueue_, partialsKernel_, 1, nullptr, localWorkSize_, localWorkSize_, 0, nullptr, nullptr);
+    clEnqueueReadBuffer(commandQueue_, resultBuffer_, CL_TRUE, 0, sizeof(result), result, 0, nullptr, nullptr);
+    
+    memcpy(&distance, &result[1], sizeof(cl_float));
+    
+    // No distance below FLT_MAX, the host scan used to fall back to the first node
+    return result[0] == CL_UINT_MAX ? 0 : result[0];
+}
@@ -12,26 +12,20 @@
 
 #include "chebyshev_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-ChebyshevDistanceKernel::ChebyshevDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-WeightDistanceKernel("__kernel void chebyshevDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+ChebyshevDistanceKernel::ChebyshevDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options) :
+WeightDistanceKernel("float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
+                     "    VECTOR max = 0.0f;"
                      ""
-                     "    float distance = 0.0;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "    float max = 0.0;"
-                     ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
-                     ""
-                     "        float value = fabs(inputVector[i] - weights[index]);"
-                     ""
-                     "        if (value > max) {"
-                     "            max = value;"
-                     "        }"
+                     "        max = fmax(max, fabs(input - weight));"
                      "    }"
                      ""
-                     "    result[id] = max;"
-                     "}", "chebyshevDistance", context, commandQueue, deviceId) {}
+                     "    return MAXIMUM(max);"
+                     "}", options, context, commandQueue, deviceId) {}
@@ -12,26 +12,24 @@
 
 #include "cosine_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-CosineDistanceKernel::CosineDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-WeightDistanceKernel("__kernel void cosineDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+CosineDistanceKernel::CosineDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options) :
+WeightDistanceKernel("float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
+                     "    VECTOR sum1 = 0.0f;"
+                     "    VECTOR sum2 = 0.0f;"
+                     "    VECTOR sum3 = 0.0f;"
                      ""
-                     "    float distance = 0.0;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "    float sum1 = 0.0;"
-                     "    float sum2 = 0.0;"
-                     "    float sum3 = 0.0;"
-                     ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
-                     ""
-                     "        sum1 += inputVector[i] * weights[index];"
-                     "        sum2 += inputVector[i] * inputVector[i];"
-                     "        sum3 += weights[index] * weights[index];"
+                     "        sum1 += input * weight;"
+                     "        sum2 += input * input;"
+                     "        sum3 += weight * weight;"
                      "    }"
                      ""
-                     "    result[id] = 1.0 - ( sum1 / (sqrt(sum2) * sqrt(sum3)) );"
-                     "}", "cosineDistance", context, commandQueue, deviceId) {}
+                     "    return 1.0f - ( SUM(sum1) / (sqrt(SUM(sum2)) * sqrt(SUM(sum3))) );"
+                     "}", options, context, commandQueue, deviceId) {}
@@ -12,23 +12,25 @@
 
 #include "euclidean_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-EuclideanDistanceKernel::EuclideanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-WeightDistanceKernel("__kernel void euclideanDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+EuclideanDistanceKernel::EuclideanDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options) :
+WeightDistanceKernel("float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
              "{"
-             "    int id = get_global_id(0);"
+             "    VECTOR distance = 0.0f;"
              ""
-             "    float distance = 0.0;"
+             "    for (int i = 0; i < CHUNKS; i++) {"
+             "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+             "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
              ""
-             "    for (int i = 0; i < vecSize; i++) {"
-             "        int index = id * vecSize + i;"
+             "        VECTOR difference = input - weight;"
              ""
-             "        distance += (inputVector[i] - weights[index]) * (inputVector[i] - weights[index]);"
+             "        distance += difference * difference;"
              "    }"
              ""
-             "    result[id] = sqrt(distance);"
-             "}", "euclideanDistance", context, commandQueue, deviceId) {}
+             "    return sqrt(SUM(distance));"
+             "}", options, context, commandQueue, deviceId) {}
 
 
 
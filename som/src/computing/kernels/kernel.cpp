@@ -11,19 +11,15 @@
 */
 
 #include "kernel.hpp"
+#include "runtime.hpp"
 
 using namespace std;
 using namespace som;
 
-Kernel::Kernel(const string code, const string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-commandQueue_(commandQueue), context_(context)
+Kernel::Kernel(const string code, const string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string options) :
+commandQueue_(commandQueue), context_(context), globalWorkOffset_{0}
 {
-    const char *source_str = code.c_str();
-    size_t source_size = code.size();
-    
-    program_ = clCreateProgramWithSource(context, 1, (const char **)&source_str, (const size_t *)&source_size, nullptr);
-    
-    clBuildProgram(program_, 1, &deviceId, nullptr, nullptr, nullptr);
+    program_ = Runtime::shared().program(code, context, deviceId, options);
     
     kernel_ = clCreateKernel(program_, name.c_str(), nullptr);
 }
@@ -12,20 +12,20 @@
 
 #include "mae_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-MAEDistanceKernel::MAEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-WeightDistanceKernel("__kernel void maeDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+MAEDistanceKernel::MAEDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options) :
+WeightDistanceKernel("float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
+                     "    VECTOR distance = 0.0f;"
                      ""
-                     "    float distance = 0.0;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
-                     ""
-                     "        distance += fabs(inputVector[i] - weights[index]);"
+                     "        distance += fabs(input - weight);"
                      "    }"
                      ""
-                     "    result[id] = (1.0 / vecSize) * distance;"
-                     "}", "maeDistance", context, commandQueue, deviceId) {}
+                     "    return (1.0f / CHANNELS) * SUM(distance);"
+                     "}", options, context, commandQueue, deviceId) {}
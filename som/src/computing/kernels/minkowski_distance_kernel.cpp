@@ -12,38 +12,37 @@
 
 #include "minkowski_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-MinkowskiDistanceKernel::MinkowskiDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, Device device) :
+MinkowskiDistanceKernel::MinkowskiDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options, Device device) :
 WeightDistanceKernel(device == GPU ?
-                     "__kernel void minkowskiDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+                     "float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
+                     "    VECTOR distance = 0.0f;"
+                     "    VECTOR p = 3.0f;"
                      ""
-                     "    float distance = 0.0;"
-                     "    float p = 3.0;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
-                     ""
-                     "        distance += pow(fabs(inputVector[i] - weights[index]), p);"
+                     "        distance += pow(fabs(input - weight), p);"
                      "    }"
                      ""
-                     "    result[id] = pow(distance, 1.0/p);"
+                     "    return pow(SUM(distance), 1.0f / 3.0f);"
                      "}"
                      :
-                     "__kernel void minkowskiDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+                     "float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
-                     ""
-                     "    float distance = 0.0;"
-                     "    float p = 3.0;"
+                     "    VECTOR distance = 0.0f;"
+                     "    VECTOR p = 3.0f;"
                      ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "        distance += pow(fabs(inputVector[i] - weights[index]), p);"
+                     "        distance += pow(fabs(input - weight), p);"
                      "    }"
                      ""
-                     "    result[id] = exp((1.0/p) * log(distance));"
-                     "}", "minkowskiDistance", context, commandQueue, deviceId) {}
+                     "    return exp((1.0f / 3.0f) * log(SUM(distance)));"
+                     "}", options, context, commandQueue, deviceId) {}
@@ -0,0 +1,319 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "program_cache.hpp"
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    static const string CACHE_HEADER = "SOM program cache 1";
+    
+    static string defaultDirectory() {
+        const char *directory = getenv("SOM_PROGRAM_CACHE_DIR");
+        
+        if (directory && *directory) {
+            return directory;
+        }
+        
+#if defined(_WIN32)
+        const char *localAppData = getenv("LOCALAPPDATA");
+        
+        return localAppData ? string(localAppData) + "/som" : "";
+#elif defined(__APPLE__)
+        const char *home = getenv("HOME");
+        
+        return home ? string(home) + "/Library/Caches/som" : "";
+#else
+        const char *cacheHome = getenv("XDG_CACHE_HOME");
+        const char *home = getenv("HOME");
+        
+        if (cacheHome && *cacheHome) {
+            return string(cacheHome) + "/som";
+        }
+        
+        return home ? string(home) + "/.cache/som" : "";
+#endif
+    }
+    
+    struct ProgramCacheSettings {
+        mutex settingsMutex;
+        bool enabled;
+        string directory;
+        
+        ProgramCacheSettings() :
+        enabled(true),
+        directory(defaultDirectory()) {
+            const char *enabledVariable = getenv("SOM_PROGRAM_CACHE");
+            
+            if (enabledVariable) {
+                string value(enabledVariable);
+                
+                enabled = !(value == "0" || value == "off" || value == "false");
+            }
+        }
+    };
+    
+    static ProgramCacheSettings & settings() {
+        static ProgramCacheSettings settings;
+        
+        return settings;
+    }
+    
+    // FNV-1a, stable across runs and platforms unlike std::hash
+    static string hashString(const string &value) {
+        uint64_t result = 14695981039346656037ULL;
+        
+        for (unsigned char c : value) {
+            result = (result ^ c) * 1099511628211ULL;
+        }
+        
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)result);
+        
+        return buffer;
+    }
+    
+    static bool makeDirectories(const string &path) {
+        for (size_t i = 1; i <= path.size(); i++) {
+            if (i == path.size() || path[i] == '/' || path[i] == '\\') {
+#ifdef _WIN32
+                _mkdir(path.substr(0, i).c_str());
+#else
+                mkdir(path.substr(0, i).c_str(), 0755);
+#endif
+            }
+        }
+        
+        struct stat info;
+        
+        return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+    }
+    
+    static string deviceInfo(const cl_device_id &deviceId, const cl_device_info parameter) {
+        size_t size = 0;
+        
+        if (clGetDeviceInfo(deviceId, parameter, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+            return "";
+        }
+        
+        vector<char> value(size);
+        clGetDeviceInfo(deviceId, parameter, size, value.data(), nullptr);
+        
+        return string(value.data());
+    }
+    
+    static string platformInfo(const cl_device_id &deviceId, const cl_platform_info parameter) {
+        cl_platform_id platformId = nullptr;
+        size_t size = 0;
+        
+        if (clGetDeviceInfo(deviceId, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platformId, nullptr) != CL_SUCCESS ||
+            clGetPlatformInfo(platformId, parameter, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+            return "";
+        }
+        
+        vector<char> value(size);
+        clGetPlatformInfo(platformId, parameter, size, value.data(), nullptr);
+        
+        return string(value.data());
+    }
+}
+
+#pragma mark - Settings
+
+void ProgramCache::setEnabled(const bool enabled) {
+    unique_lock<mutex> lock(settings().settingsMutex);
+    settings().enabled = enabled;
+}
+
+bool ProgramCache::isEnabled() {
+    unique_lock<mutex> lock(settings().settingsMutex);
+    
+    return settings().enabled;
+}
+
+void ProgramCache::setDirectory(const string &path) {
+    unique_lock<mutex> lock(settings().settingsMutex);
+    settings().directory = path;
+}
+
+string ProgramCache::getDirectory() {
+    unique_lock<mutex> lock(settings().settingsMutex);
+    
+    return settings().directory;
+}
+
+#pragma mark - Build
+
+cl_program ProgramCache::build(const string &code, cl_context &context, cl_device_id &deviceId, const string &options) {
+    string directory;
+    bool enabled;
+    
+    {
+        unique_lock<mutex> lock(settings().settingsMutex);
+        enabled = settings().enabled;
+        directory = settings().directory;
+    }
+    
+    if (!enabled || directory.empty()) {
+        return buildFromSource(code, context, deviceId, options);
+    }
+    
+    // The versions aren't part of the name, so a driver update overwrites the stale entry instead of adding one
+    auto identity = deviceIdentity(deviceId);
+    auto path = directory + "/" + hashString(deviceName(deviceId)) + "-" + hashString(options + "\n" + code) + ".bin";
+    
+    cl_program program = buildFromBinary(path, identity, context, deviceId, options);
+    
+    if (program) {
+        return program;
+    }
+    
+    program = buildFromSource(code, context, deviceId, options);
+    
+    if (program) {
+        store(directory, path, identity, program, deviceId);
+    }
+    
+    return program;
+}
+
+cl_program ProgramCache::buildFromBinary(const string &path, const string &identity, cl_context &context, cl_device_id &deviceId, const string &options) {
+    ifstream file(path, ios::binary);
+    
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    
+    string header, storedIdentity;
+    size_t size = 0;
+    
+    getline(file, header);
+    getline(file, storedIdentity);
+    file >> size;
+    file.get();
+    
+    if (!file || header != CACHE_HEADER || storedIdentity != identity || size == 0) {
+        return nullptr;
+    }
+    
+    vector<unsigned char> binary(size);
+    file.read((char *)binary.data(), size);
+    
+    if (!file) {
+        return nullptr;
+    }
+    
+    const unsigned char *binaries = binary.data();
+    cl_int binaryStatus = CL_SUCCESS;
+    cl_int error = CL_SUCCESS;
+    
+    cl_program program = clCreateProgramWithBinary(context, 1, &deviceId, &size, &binaries, &binaryStatus, &error);
+    
+    if (error != CL_SUCCESS || binaryStatus != CL_SUCCESS ||
+        clBuildProgram(program, 1, &deviceId, options.c_str(), nullptr, nullptr) != CL_SUCCESS) {
+        if (program) {
+            clReleaseProgram(program);
+        }
+        
+        return nullptr;
+    }
+    
+    return program;
+}
+
+cl_program ProgramCache::buildFromSource(const string &code, cl_context &context, cl_device_id &deviceId, const string &options) {
+    const char *source_str = code.c_str();
+    size_t source_size = code.size();
+    
+    cl_program program = clCreateProgramWithSource(context, 1, (const char **)&source_str, (const size_t *)&source_size, nullptr);
+    
+    clBuildProgram(program, 1, &deviceId, options.c_str(), nullptr, nullptr);
+    
+    return program;
+}
+
+void ProgramCache::store(const string &directory, const string &path, const string &identity, const cl_program &program, cl_device_id &deviceId) {
+    cl_build_status buildStatus = CL_BUILD_ERROR;
+    size_t size = 0;
+    
+    if (clGetProgramBuildInfo(program, deviceId, CL_PROGRAM_BUILD_STATUS, sizeof(cl_build_status), &buildStatus, nullptr) != CL_SUCCESS ||
+        buildStatus != CL_BUILD_SUCCESS ||
+        clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &size, nullptr) != CL_SUCCESS || size == 0) {
+        return;
+    }
+    
+    vector<unsigned char> binary(size);
+    unsigned char *binaries = binary.data();
+    
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char *), &binaries, nullptr) != CL_SUCCESS || !makeDirectories(directory)) {
+        return;
+    }
+    
+    // Written aside and renamed, so other processes never read a partial entry
+    auto uniqueness = to_string(chrono::steady_clock::now().time_since_epoch().count()) + to_string(std::hash<thread::id>()(this_thread::get_id()));
+    auto temporaryPath = path + "." + hashString(uniqueness) + ".tmp";
+    
+    {
+        ofstream file(temporaryPath, ios::binary | ios::trunc);
+        
+        file << CACHE_HEADER << "\n" << identity << "\n" << size << "\n";
+        file.write((const char *)binary.data(), size);
+        
+        if (!file) {
+            file.close();
+            remove(temporaryPath.c_str());
+            
+            return;
+        }
+    }
+    
+    if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        remove(path.c_str());
+        
+        if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            remove(temporaryPath.c_str());
+        }
+    }
+}
+
+#pragma mark - Device
+
+string ProgramCache::deviceName(const cl_device_id &deviceId) {
+    return platformInfo(deviceId, CL_PLATFORM_NAME) + " " + deviceInfo(deviceId, CL_DEVICE_VENDOR) + " " + deviceInfo(deviceId, CL_DEVICE_NAME);
+}
+
+string ProgramCache::deviceIdentity(const cl_device_id &deviceId) {
+    auto identity = deviceName(deviceId) + " | " + platformInfo(deviceId, CL_PLATFORM_VERSION) + " | " + deviceInfo(deviceId, CL_DEVICE_VERSION) + " | " + deviceInfo(deviceId, CL_DRIVER_VERSION);
+    
+    // Kept on one line of the entry header
+    for (auto &c : identity) {
+        if (c == '\n' || c == '\r') {
+            c = ' ';
+        }
+    }
+    
+    return identity;
+}
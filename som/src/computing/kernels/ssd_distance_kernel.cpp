@@ -12,20 +12,22 @@
 
 #include "ssd_distance_kernel.hpp"
 
+using namespace std;
 using namespace som;
 
-SSDDistanceKernel::SSDDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-WeightDistanceKernel("__kernel void ssdDistance(__global float *inputVector, __global float *weights, unsigned int vecSize, __global float *result)"
+SSDDistanceKernel::SSDDistanceKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options) :
+WeightDistanceKernel("float weightDistance(__global float *inputVector, __global float *weights, unsigned int channelStride)"
                      "{"
-                     "    int id = get_global_id(0);"
+                     "    VECTOR distance = 0.0f;"
                      ""
-                     "    float distance = 0.0;"
+                     "    for (int i = 0; i < CHUNKS; i++) {"
+                     "        VECTOR input = loadChunk(inputVector, i, 0.0f);"
+                     "        VECTOR weight = loadWeights(weights, channelStride, i, 0.0f);"
                      ""
-                     "    for (int i = 0; i < vecSize; i++) {"
-                     "        int index = id * vecSize + i;"
+                     "        VECTOR difference = input - weight;"
                      ""
-                     "        distance += pow(inputVector[i] - weights[index], 2);"
+                     "        distance += difference * difference;"
                      "    }"
                      ""
-                     "    result[id] = distance;"
-                     "}", "ssdDistance", context, commandQueue, deviceId) {}
+                     "    return SUM(distance);"
+                     "}", options, context, commandQueue, deviceId) {}
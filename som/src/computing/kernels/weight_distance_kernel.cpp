@@ -11,35 +11,450 @@
 */
 
 #include "weight_distance_kernel.hpp"
+#include "bmu_reduction_kernel.hpp"
 #include "model.hpp"
 
 using namespace std;
 using namespace som;
 
-WeightDistanceKernel::WeightDistanceKernel(const string code, const string name, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
-Kernel(code, name, context, commandQueue, deviceId) {}
+namespace som {
+    // The channels and the vector width are compiled in, the loops over a node are unrolled and vectorized.
+    // The chunk past the last full vector is padded.
+    static const string CHANNELS_CODE =
+    "#if VECTOR_WIDTH == 16\n"
+    "#define VECTOR float16\n"
+    "#define VLOAD vload16\n"
+    "#define SUM sum16\n"
+    "#define MAXIMUM maximum16\n"
+    "#elif VECTOR_WIDTH == 8\n"
+    "#define VECTOR float8\n"
+    "#define VLOAD vload8\n"
+    "#define SUM sum8\n"
+    "#define MAXIMUM maximum8\n"
+    "#else\n"
+    "#define VECTOR float4\n"
+    "#define VLOAD vload4\n"
+    "#define SUM sum4\n"
+    "#define MAXIMUM maximum4\n"
+    "#endif\n"
+    ""
+    "#define FULL_CHUNKS (CHANNELS / VECTOR_WIDTH)\n"
+    "#define CHUNKS ((CHANNELS + VECTOR_WIDTH - 1) / VECTOR_WIDTH)\n"
+    ""
+    "float sum4(float4 value) { float2 half = value.lo + value.hi; return half.x + half.y; }"
+    "float sum8(float8 value) { return sum4(value.lo + value.hi); }"
+    "float sum16(float16 value) { return sum8(value.lo + value.hi); }"
+    ""
+    "float maximum4(float4 value) { float2 half = fmax(value.lo, value.hi); return fmax(half.x, half.y); }"
+    "float maximum8(float8 value) { return maximum4(fmax(value.lo, value.hi)); }"
+    "float maximum16(float16 value) { return maximum8(fmax(value.lo, value.hi)); }"
+    ""
+    "VECTOR loadChunk(__global float *values, int chunk, float padding)"
+    "{"
+    "    if (chunk < FULL_CHUNKS) {"
+    "        return VLOAD(chunk, values);"
+    "    }"
+    ""
+    "    float tail[VECTOR_WIDTH];"
+    ""
+    "    for (int i = 0; i < VECTOR_WIDTH; i++) {"
+    "        tail[i] = i < CHANNELS % VECTOR_WIDTH ? values[chunk * VECTOR_WIDTH + i] : padding;"
+    "    }"
+    ""
+    "    return VLOAD(0, tail);"
+    "}\n"
+    ""
+    "#ifdef CHANNEL_MAJOR\n"
+    "#define NODE_STRIDE 1\n"
+    "#else\n"
+    "#define NODE_STRIDE CHANNELS\n"
+    "#endif\n"
+    ""
+    "VECTOR loadWeights(__global float *weights, unsigned int channelStride, int chunk, float padding)"
+    "{\n"
+    "#ifdef CHANNEL_MAJOR\n"
+    "    float values[VECTOR_WIDTH];"
+    ""
+    "    for (int i = 0; i < VECTOR_WIDTH; i++) {"
+    "        int channel = chunk * VECTOR_WIDTH + i;"
+    ""
+    "        values[i] = channel < CHANNELS ? weights[channel * channelStride] : padding;"
+    "    }"
+    ""
+    "    return VLOAD(0, values);\n"
+    "#else\n"
+    "    return loadChunk(weights, chunk, padding);\n"
+    "#endif\n"
+    "}";
+}
+
+size_t WeightDistanceKernel::vectorWidth(const size_t channels) {
+    return channels >= 16 ? 16 : channels >= 8 ? 8 : 4;
+}
+
+const size_t WeightDistanceKernel::MAX_TOP_K;
+
+string WeightDistanceKernel::buildOptions(const size_t channels, const WeightsLayout layout) {
+    auto options = "-D CHANNELS=" + to_string(channels) + " -D VECTOR_WIDTH=" + to_string(vectorWidth(channels)) + " -D MAX_TOP_K=" + to_string(MAX_TOP_K);
+    
+    if (layout == CHANNEL_MAJOR) {
+        options += " -D CHANNEL_MAJOR";
+    }
+    
+    return options;
+}
+
+WeightDistanceKernel::WeightDistanceKernel(const string distanceCode, const string &options, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
+Kernel(CHANNELS_CODE + distanceCode + BmuReductionKernel::localReductionCode +
+       "__kernel void weightDistances(__global float *inputVector, __global float *weights, __global float *result, unsigned int channelStride)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    result[id] = weightDistance(inputVector, &weights[id * NODE_STRIDE], channelStride);"
+       "}"
+       ""
+       "__kernel void bmuIndices(__global float *inputVectors, __global float *weights, unsigned int nodesCount,"
+       "                         __global unsigned int *result, __local float *localDistances, __local unsigned int *localIndices, unsigned int channelStride)"
+       "{"
+       "    int inputIndex = get_global_id(1);"
+       ""
+       "    __global float *inputVector = &inputVectors[inputIndex * CHANNELS];"
+       ""
+       "    float lowestDistance = FLT_MAX;"
+       "    unsigned int index = UINT_MAX;"
+       ""
+       "    for (unsigned int i = get_global_id(0); i < nodesCount; i += get_local_size(0)) {"
+       "        float distance = weightDistance(inputVector, &weights[i * NODE_STRIDE], channelStride);"
+       ""
+       "        if (distance < lowestDistance) {"
+       "            lowestDistance = distance;"
+       "            index = i;"
+       "        }"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    if (get_local_id(0) == 0) {"
+       "        result[inputIndex] = localIndices[0] == UINT_MAX ? 0 : localIndices[0];"
+       "    }"
+       "}"
+       ""
+       "__kernel void packedBmuIndices(__global float *inputVectors, __global float *weights, __global unsigned int *offsets,"
+       "                               __global unsigned int *models, __global unsigned int *result,"
+       "                               __local float *localDistances, __local unsigned int *localIndices, unsigned int channelStride)"
+       "{"
+       "    int inputIndex = get_global_id(1);"
+       "    unsigned int model = models[inputIndex];"
+       "    unsigned int begin = offsets[model];"
+       "    unsigned int end = offsets[model + 1];"
+       ""
+       "    __global float *inputVector = &inputVectors[inputIndex * CHANNELS];"
+       ""
+       "    float lowestDistance = FLT_MAX;"
+       "    unsigned int index = UINT_MAX;"
+       ""
+       "    for (unsigned int i = begin + get_local_id(0); i < end; i += get_local_size(0)) {"
+       "        float distance = weightDistance(inputVector, &weights[i * NODE_STRIDE], channelStride);"
+       ""
+       "        if (distance < lowestDistance) {"
+       "            lowestDistance = distance;"
+       "            index = i;"
+       "        }"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    if (get_local_id(0) == 0) {"
+       "        result[inputIndex] = localIndices[0] == UINT_MAX ? 0 : localIndices[0] - begin;"
+       "    }"
+       "}"
+       ""
+       "__kernel void topK(__global float *inputVectors, __global float *weights, unsigned int nodesCount, unsigned int k,"
+       "                   __global unsigned int *resultIndices, __global float *resultDistances,"
+       "                   __local float *localDistances, __local unsigned int *localIndices, unsigned int channelStride)"
+       "{"
+       "    int inputIndex = get_global_id(1);"
+       ""
+       "    __global float *inputVector = &inputVectors[inputIndex * CHANNELS];"
+       ""
+       "    float topDistances[MAX_TOP_K];"
+       "    unsigned int topIndices[MAX_TOP_K];"
+       ""
+       "    for (int i = 0; i < k; i++) {"
+       "        topDistances[i] = FLT_MAX;"
+       "        topIndices[i] = UINT_MAX;"
+       "    }"
+       ""
+       "    for (unsigned int i = get_global_id(0); i < nodesCount; i += get_local_size(0)) {"
+       "        float distance = weightDistance(inputVector, &weights[i * NODE_STRIDE], channelStride);"
+       ""
+       "        if (distance < topDistances[k - 1]) {"
+       "            int j = k - 1;"
+       ""
+       "            for (; j > 0 && topDistances[j - 1] > distance; j--) {"
+       "                topDistances[j] = topDistances[j - 1];"
+       "                topIndices[j] = topIndices[j - 1];"
+       "            }"
+       ""
+       "            topDistances[j] = distance;"
+       "            topIndices[j] = i;"
+       "        }"
+       "    }"
+       ""
+       "    int head = 0;"
+       ""
+       "    for (int rank = 0; rank < k; rank++) {"
+       "        float distance = head < k ? topDistances[head] : FLT_MAX;"
+       "        unsigned int index = head < k ? topIndices[head] : UINT_MAX;"
+       ""
+       "        reduceLocal(localDistances, localIndices, distance, index);"
+       ""
+       "        float nearestDistance = localDistances[0];"
+       "        unsigned int nearest = localIndices[0];"
+       ""
+       "        if (get_local_id(0) == 0) {"
+       "            resultIndices[inputIndex * k + rank] = nearest;"
+       "            resultDistances[inputIndex * k + rank] = nearestDistance;"
+       "        }"
+       ""
+       "        barrier(CLK_LOCAL_MEM_FENCE);"
+       ""
+       "        if (index == nearest && nearest != UINT_MAX) {"
+       "            head++;"
+       "        }"
+       "    }"
+       "}"
+       ""
+       "__kernel void errors(__global float *inputVectors, __global float *weights, unsigned int nodesCount, __global float *points, float maxAdjacentDistance,"
+       "                     __global float *result, __local float *localDistances, __local unsigned int *localIndices, unsigned int channelStride)"
+       "{"
+       "    int inputIndex = get_global_id(1);"
+       ""
+       "    __global float *inputVector = &inputVectors[inputIndex * CHANNELS];"
+       ""
+       "    float lowestDistance = FLT_MAX;"
+       "    float secondDistance = FLT_MAX;"
+       "    unsigned int index = UINT_MAX;"
+       "    unsigned int secondIndex = UINT_MAX;"
+       ""
+       "    for (unsigned int i = get_global_id(0); i < nodesCount; i += get_local_size(0)) {"
+       "        float distance = weightDistance(inputVector, &weights[i * NODE_STRIDE], channelStride);"
+       ""
+       "        if (distance < lowestDistance) {"
+       "            secondDistance = lowestDistance;"
+       "            secondIndex = index;"
+       "            lowestDistance = distance;"
+       "            index = i;"
+       "        } else if (distance < secondDistance) {"
+       "            secondDistance = distance;"
+       "            secondIndex = i;"
+       "        }"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    float bmuDistance = localDistances[0];"
+       "    unsigned int bmu = localIndices[0];"
+       ""
+       "    barrier(CLK_LOCAL_MEM_FENCE);"
+       ""
+       "    if (index == bmu) {"
+       "        lowestDistance = secondDistance;"
+       "        index = secondIndex;"
+       "    }"
+       ""
+       "    reduceLocal(localDistances, localIndices, lowestDistance, index);"
+       ""
+       "    if (get_local_id(0) == 0) {"
+       "        unsigned int second = localIndices[0];"
+       "        float topographicError = 0.0f;"
+       ""
+       "        if (bmu != UINT_MAX && second != UINT_MAX) {"
+       "            float dx = points[bmu * 2] - points[second * 2];"
+       "            float dy = points[bmu * 2 + 1] - points[second * 2 + 1];"
+       ""
+       "            topographicError = dx * dx + dy * dy > maxAdjacentDistance ? 1.0f : 0.0f;"
+       "        }"
+       ""
+       "        result[inputIndex * 2] = bmu == UINT_MAX ? 0.0f : bmuDistance;"
+       "        result[inputIndex * 2 + 1] = topographicError;"
+       "    }"
+       "}"
+       ""
+       "__kernel void sumErrors(__global float *errors, unsigned int count, __global float *partials, unsigned int partialsOffset, __local float *localSums)"
+       "{"
+       "    int localId = get_local_id(0);"
+       ""
+       "    float distancesSum = 0.0f;"
+       "    float topographicErrorsSum = 0.0f;"
+       ""
+       "    for (unsigned int i = get_global_id(0); i < count; i += get_global_size(0)) {"
+       "        distancesSum += errors[i * 2];"
+       "        topographicErrorsSum += errors[i * 2 + 1];"
+       "    }"
+       ""
+       "    localSums[localId * 2] = distancesSum;"
+       "    localSums[localId * 2 + 1] = topographicErrorsSum;"
+       ""
+       "    barrier(CLK_LOCAL_MEM_FENCE);"
+       ""
+       "    for (int offset = get_local_size(0) / 2; offset > 0; offset /= 2) {"
+       "        if (localId < offset) {"
+       "            localSums[localId * 2] += localSums[(localId + offset) * 2];"
+       "            localSums[localId * 2 + 1] += localSums[(localId + offset) * 2 + 1];"
+       "        }"
+       ""
+       "        barrier(CLK_LOCAL_MEM_FENCE);"
+       "    }"
+       ""
+       "    if (localId == 0) {"
+       "        partials[(partialsOffset + get_group_id(0)) * 2] = localSums[0];"
+       "        partials[(partialsOffset + get_group_id(0)) * 2 + 1] = localSums[1];"
+       "    }"
+       "}", "weightDistances", context, commandQueue, deviceId, options),
+bmuIndicesKernel_(nullptr),
+packedBmuIndicesKernel_(nullptr),
+topKKernel_(nullptr),
+errorsKernel_(nullptr),
+sumErrorsKernel_(nullptr) {
+    bmuIndicesKernel_ = clCreateKernel(program_, "bmuIndices", nullptr);
+    packedBmuIndicesKernel_ = clCreateKernel(program_, "packedBmuIndices", nullptr);
+    topKKernel_ = clCreateKernel(program_, "topK", nullptr);
+    errorsKernel_ = clCreateKernel(program_, "errors", nullptr);
+    sumErrorsKernel_ = clCreateKernel(program_, "sumErrors", nullptr);
+    
+    localWorkSize_[0] = BmuReductionKernel::localWorkSize(bmuIndicesKernel_, deviceId);
+    localWorkSize_[1] = 1;
+}
 
-void WeightDistanceKernel::connect(const Model &model, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &distancesBuffer) {
+WeightDistanceKernel::~WeightDistanceKernel() {
+    clReleaseKernel(bmuIndicesKernel_);
+    clReleaseKernel(packedBmuIndicesKernel_);
+    clReleaseKernel(topKKernel_);
+    clReleaseKernel(errorsKernel_);
+    clReleaseKernel(sumErrorsKernel_);
+}
+
+void WeightDistanceKernel::connect(const Model &model, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &distancesBuffer, const cl_mem &pointsBuffer) {
     inputBuffer_ = inputBuffer;
     weightsBuffer_ = weightsBuffer;
     distancesBuffer_ = distancesBuffer;
     
-    weights_ = &model.getWeights();
-    distances_ = &model.getDistances();
     channels_ = model.getChannelsCount();
     nodesCount_ = model.getNodesCount();
     
     clSetKernelArg(kernel_, 0, sizeof(cl_mem), &inputBuffer_);
     clSetKernelArg(kernel_, 1, sizeof(cl_mem), &weightsBuffer_);
-    clSetKernelArg(kernel_, 2, sizeof(cl_uint), &channels_);
-    clSetKernelArg(kernel_, 3, sizeof(cl_mem), &distancesBuffer_);
+    clSetKernelArg(kernel_, 2, sizeof(cl_mem), &distancesBuffer_);
+    
+    // No need for more work-items than nodes
+    while (localWorkSize_[0] / 2 >= nodesCount_ && localWorkSize_[0] > 1) {
+        localWorkSize_[0] /= 2;
+    }
+    
+    clSetKernelArg(bmuIndicesKernel_, 1, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(bmuIndicesKernel_, 4, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(bmuIndicesKernel_, 5, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    
+    clSetKernelArg(topKKernel_, 1, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(topKKernel_, 6, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(topKKernel_, 7, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    
+    clSetKernelArg(errorsKernel_, 1, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(errorsKernel_, 3, sizeof(cl_mem), &pointsBuffer);
+    clSetKernelArg(errorsKernel_, 6, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(errorsKernel_, 7, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    
+    clSetKernelArg(sumErrorsKernel_, 4, localWorkSize_[0] * 2 * sizeof(cl_float), nullptr);
     
-    globalWorkSize_[0] = nodesCount_;
+    // The channels of a node lie a map apart in the channel-major layout, the node-major one ignores the stride
+    cl_uint channelStride = (cl_uint)nodesCount_;
+    
+    clSetKernelArg(kernel_, 3, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(bmuIndicesKernel_, 6, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(topKKernel_, 8, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(errorsKernel_, 8, sizeof(cl_uint), &channelStride);
+    
+    setNodesRange(0, nodesCount_);
+}
+
+void WeightDistanceKernel::setNodesRange(const size_t begin, const size_t end) {
+    cl_uint nodesEnd = (cl_uint)end;
+    
+    // The distances are computed by a work-item per node, the searches by a work-group per vector walking the nodes
+    // from the offset of its first dimension
+    globalWorkOffset_[0] = begin;
+    globalWorkSize_[0] = end - begin;
+    
+    searchWorkOffset_[0] = begin;
+    searchWorkOffset_[1] = 0;
+    
+    clSetKernelArg(bmuIndicesKernel_, 2, sizeof(cl_uint), &nodesEnd);
+    clSetKernelArg(topKKernel_, 2, sizeof(cl_uint), &nodesEnd);
+    clSetKernelArg(errorsKernel_, 2, sizeof(cl_uint), &nodesEnd);
 }
 
 void WeightDistanceKernel::compute(const cl_float &vector) {
-    clEnqueueWriteBuffer(commandQueue_, weightsBuffer_, CL_TRUE, 0, nodesCount_ * channels_ * sizeof(cl_float), &weights_[0], 0, nullptr, nullptr);
-    clEnqueueWriteBuffer(commandQueue_, inputBuffer_, CL_TRUE, 0, channels_ * sizeof(cl_float), &vector, 0, nullptr, nullptr);
-    clEnqueueNDRangeKernel(commandQueue_, kernel_, 1, nullptr, globalWorkSize_, nullptr, 0, nullptr, nullptr);
-    clEnqueueReadBuffer(commandQueue_, distancesBuffer_, CL_TRUE, 0, nodesCount_ * sizeof(cl_float), &distances_[0], 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(commandQueue_, inputBuffer_, CL_FALSE, 0, channels_ * sizeof(cl_float), &vector, 0, nullptr, nullptr);
+    clEnqueueNDRangeKernel(commandQueue_, kernel_, 1, globalWorkOffset_, globalWorkSize_, nullptr, 0, nullptr, nullptr);
+}
+
+void WeightDistanceKernel::computeBmuIndices(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count, const cl_event *waitEvent, cl_event *event) {
+    size_t globalWorkSize[2] = {localWorkSize_[0], count};
+    
+    clSetKernelArg(bmuIndicesKernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(bmuIndicesKernel_, 3, sizeof(cl_mem), &bmuIndicesBuffer);
+    
+    clEnqueueNDRangeKernel(commandQueue_, bmuIndicesKernel_, 2, searchWorkOffset_, globalWorkSize, localWorkSize_, waitEvent ? 1 : 0, waitEvent, event);
+}
+
+void WeightDistanceKernel::computePackedBmuIndices(const cl_mem &inputVectorsBuffer, const cl_mem &weightsBuffer, const cl_mem &offsetsBuffer, const cl_mem &modelsBuffer, const cl_mem &bmuIndicesBuffer, const size_t count) {
+    size_t globalWorkSize[2] = {localWorkSize_[0], count};
+    cl_uint channelStride = 1;
+    
+    clSetKernelArg(packedBmuIndicesKernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(packedBmuIndicesKernel_, 1, sizeof(cl_mem), &weightsBuffer);
+    clSetKernelArg(packedBmuIndicesKernel_, 2, sizeof(cl_mem), &offsetsBuffer);
+    clSetKernelArg(packedBmuIndicesKernel_, 3, sizeof(cl_mem), &modelsBuffer);
+    clSetKernelArg(packedBmuIndicesKernel_, 4, sizeof(cl_mem), &bmuIndicesBuffer);
+    clSetKernelArg(packedBmuIndicesKernel_, 5, localWorkSize_[0] * sizeof(cl_float), nullptr);
+    clSetKernelArg(packedBmuIndicesKernel_, 6, localWorkSize_[0] * sizeof(cl_uint), nullptr);
+    clSetKernelArg(packedBmuIndicesKernel_, 7, sizeof(cl_uint), &channelStride);
+    
+    clEnqueueNDRangeKernel(commandQueue_, packedBmuIndicesKernel_, 2, nullptr, globalWorkSize, localWorkSize_, 0, nullptr, nullptr);
+}
+
+void WeightDistanceKernel::computeTopK(const cl_mem &inputVectorsBuffer, const cl_mem &indicesBuffer, const cl_mem &distancesBuffer, const size_t count, const size_t k, const cl_event *waitEvent, cl_event *event) {
+    size_t globalWorkSize[2] = {localWorkSize_[0], count};
+    cl_uint clK = (cl_uint)k;
+    
+    clSetKernelArg(topKKernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(topKKernel_, 3, sizeof(cl_uint), &clK);
+    clSetKernelArg(topKKernel_, 4, sizeof(cl_mem), &indicesBuffer);
+    clSetKernelArg(topKKernel_, 5, sizeof(cl_mem), &distancesBuffer);
+    
+    clEnqueueNDRangeKernel(commandQueue_, topKKernel_, 2, searchWorkOffset_, globalWorkSize, localWorkSize_, waitEvent ? 1 : 0, waitEvent, event);
+}
+
+void WeightDistanceKernel::computeErrors(const cl_mem &inputVectorsBuffer, const cl_mem &errorsBuffer, const size_t count, const cl_float maxAdjacentDistance, const cl_event *waitEvent) {
+    size_t globalWorkSize[2] = {localWorkSize_[0], count};
+    
+    clSetKernelArg(errorsKernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(errorsKernel_, 4, sizeof(cl_float), &maxAdjacentDistance);
+    clSetKernelArg(errorsKernel_, 5, sizeof(cl_mem), &errorsBuffer);
+    
+    clEnqueueNDRangeKernel(commandQueue_, errorsKernel_, 2, searchWorkOffset_, globalWorkSize, localWorkSize_, waitEvent ? 1 : 0, waitEvent, nullptr);
+}
+
+void WeightDistanceKernel::sumErrors(const cl_mem &errorsBuffer, const size_t count, const cl_mem &partialsBuffer, const size_t partialsOffset, const size_t groupsCount, cl_event *event) {
+    size_t globalWorkSize[1] = {localWorkSize_[0] * groupsCount};
+    cl_uint clCount = (cl_uint)count;
+    cl_uint clPartialsOffset = (cl_uint)partialsOffset;
+    
+    clSetKernelArg(sumErrorsKernel_, 0, sizeof(cl_mem), &errorsBuffer);
+    clSetKernelArg(sumErrorsKernel_, 1, sizeof(cl_uint), &clCount);
+    clSetKernelArg(sumErrorsKernel_, 2, sizeof(cl_mem), &partialsBuffer);
+    clSetKernelArg(sumErrorsKernel_, 3, sizeof(cl_uint), &clPartialsOffset);
+    
+    clEnqueueNDRangeKernel(commandQueue_, sumErrorsKernel_, 1, nullptr, globalWorkSize, localWorkSize_, 0, nullptr, event);
 }
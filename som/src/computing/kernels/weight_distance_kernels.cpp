@@ -0,0 +1,64 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "weight_distance_kernels.hpp"
+#include "sad_distance_kernel.hpp"
+#include "ssd_distance_kernel.hpp"
+#include "mae_distance_kernel.hpp"
+#include "mse_distance_kernel.hpp"
+#include "euclidean_distance_kernel.hpp"
+#include "manhattan_distance_kernel.hpp"
+#include "chebyshev_distance_kernel.hpp"
+#include "minkowski_distance_kernel.hpp"
+#include "canberra_distance_kernel.hpp"
+#include "cosine_distance_kernel.hpp"
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    template <typename T>
+    static WeightDistanceKernel * createKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options, const Device) {
+        return new T(context, commandQueue, deviceId, options);
+    }
+    
+    template <>
+    WeightDistanceKernel * createKernel<MinkowskiDistanceKernel>(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options, const Device deviceType) {
+        return new MinkowskiDistanceKernel(context, commandQueue, deviceId, options, deviceType);
+    }
+    
+    static const struct {
+        DistanceMetric metric;
+        WeightDistanceKernelFactory factory;
+    } REGISTRY[] = {
+        {EUCLIDEAN, createKernel<EuclideanDistanceKernel>},
+        {MANHATTAN, createKernel<ManhattanDistanceKernel>},
+        {CHEBYSHEV, createKernel<ChebyshevDistanceKernel>},
+        {MINKOWSKI, createKernel<MinkowskiDistanceKernel>},
+        {CANBERRA,  createKernel<CanberraDistanceKernel>},
+        {COSINE,    createKernel<CosineDistanceKernel>},
+        {SAD,       createKernel<SADDistanceKernel>},
+        {SSD,       createKernel<SSDDistanceKernel>},
+        {MAE,       createKernel<MAEDistanceKernel>},
+        {MSE,       createKernel<MSEDistanceKernel>}
+    };
+}
+
+WeightDistanceKernel * WeightDistanceKernels::create(const DistanceMetric metric, cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId, const string &options, const Device deviceType) {
+    for (auto &entry : REGISTRY) {
+        if (entry.metric == metric) {
+            return entry.factory(context, commandQueue, deviceId, options, deviceType);
+        }
+    }
+    
+    return nullptr;
+}
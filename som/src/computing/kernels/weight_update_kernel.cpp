@@ -0,0 +1,332 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "weight_update_kernel.hpp"
+#include "model.hpp"
+#include "neighbourhood.hpp"
+
+using namespace som;
+
+const string WeightUpdateKernel::neighbourhoodFunctionsCode =
+string("#define BUBBLE ") + to_string(BUBBLE) + "\n"
+"#define MEXICAN_HAT " + to_string(MEXICAN_HAT) + "\n"
+"#define CUT_GAUSSIAN " + to_string(CUT_GAUSSIAN) + "\n"
+"#define EPANECHNIKOV " + to_string(EPANECHNIKOV) + "\n"
+"#define CUT_GAUSSIAN_FLOOR 0.60653066f\n"
+""
+"float influence(float distance, float squareNeighbourhood, int function)"
+"{"
+"    float x = distance / squareNeighbourhood;"
+""
+"    switch (function) {"
+"        case BUBBLE: return 1.0f;"
+"        case MEXICAN_HAT: return (1.0f - 2.0f * x) * exp(-x);"
+"        case CUT_GAUSSIAN: return (exp(-x / 2.0f) - CUT_GAUSSIAN_FLOOR) / (1.0f - CUT_GAUSSIAN_FLOOR);"
+"        case EPANECHNIKOV: return 1.0f - x;"
+"        default: return exp(-distance / (2 * squareNeighbourhood));"
+"    }"
+"}";
+
+WeightUpdateKernel::WeightUpdateKernel(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) :
+Kernel(neighbourhoodFunctionsCode +
+       "void moveNode(__global float *inputVector, __global float *weights, unsigned int vecSize, int node, float distance, float neighbourhoodRadius, float learningRate,"
+       "              unsigned int nodeStride, unsigned int channelStride, int function)"
+       "{"
+       "    float nodeInfluence = fmax(influence(distance, neighbourhoodRadius * neighbourhoodRadius, function), 0.0f);"
+       ""
+       "    for (int i = 0; i < vecSize; i++) {"
+       "        int index = node * nodeStride + i * channelStride;"
+       ""
+       "        weights[index] += learningRate * nodeInfluence * (inputVector[i] - weights[index]);"
+       "    }"
+       "}"
+       ""
+       "__kernel void updateWeights(__global float *inputVector, __global float *weights, __global float *points, unsigned int vecSize, unsigned int bmu_index, float neighbourhoodRadius, float learningRate,"
+       "                            unsigned int nodeStride, unsigned int channelStride, float cutoffRadius, int function)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    int x = id * 2;"
+       "    int y = x + 1;"
+       "    int bmu_x = bmu_index * 2;"
+       "    int bmu_y = bmu_x + 1;"
+       ""
+       "    float distance = (points[bmu_x] - points[x]) * (points[bmu_x] - points[x]) + (points[bmu_y] - points[y]) * (points[bmu_y] - points[y]);"
+       ""
+       "    if (distance <= cutoffRadius * cutoffRadius) {"
+       "        moveNode(inputVector, weights, vecSize, id, distance, neighbourhoodRadius, learningRate, nodeStride, channelStride, function);"
+       "    }"
+       "}"
+       ""
+       "__kernel void updateWeightsTable(__global float *inputVector, __global float *weights, unsigned int vecSize,"
+       "                                 __global unsigned int *neighbours, __global float *neighbourDistances, unsigned int rowOffset,"
+       "                                 float neighbourhoodRadius, float learningRate, unsigned int nodeStride, unsigned int channelStride, int function,"
+       "                                 unsigned int nodesBegin, unsigned int nodesEnd)"
+       "{"
+       "    int id = rowOffset + get_global_id(0);"
+       "    unsigned int node = neighbours[id];"
+       ""
+       "    if (node >= nodesBegin && node < nodesEnd) {"
+       "        moveNode(inputVector, weights, vecSize, node, neighbourDistances[id], neighbourhoodRadius, learningRate, nodeStride, channelStride, function);"
+       "    }"
+       "}"
+       ""
+       "__kernel void updateWeightsStencil(__global float *inputVector, __global float *weights, unsigned int vecSize,"
+       "                                   __global int *stencil, __global float *stencilDistances, __global int *lookup,"
+       "                                   int lookupCols, int lookupRows, int bmuCol, int bmuRow,"
+       "                                   float neighbourhoodRadius, float learningRate, unsigned int nodeStride, unsigned int channelStride, int function,"
+       "                                   unsigned int nodesBegin, unsigned int nodesEnd)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    int col = bmuCol + stencil[id * 2];"
+       "    int row = bmuRow + stencil[id * 2 + 1];"
+       ""
+       "    if (col < 0 || row < 0 || col >= lookupCols || row >= lookupRows) {"
+       "        return;"
+       "    }"
+       ""
+       "    int node = lookup[col * lookupRows + row];"
+       ""
+       "    if (node >= (int)nodesBegin && node < (int)nodesEnd) {"
+       "        moveNode(inputVector, weights, vecSize, node, stencilDistances[id], neighbourhoodRadius, learningRate, nodeStride, channelStride, function);"
+       "    }"
+       "}"
+       ""
+       "__kernel void updateWeightsMiniBatch(__global float *inputVectors, __global float *weights, __global float *points, unsigned int vecSize,"
+       "                                     __global unsigned int *bmuIndices, __global float *schedule, unsigned int count,"
+       "                                     unsigned int nodeStride, unsigned int channelStride, int function)"
+       "{"
+       "    int id = get_global_id(0);"
+       ""
+       "    int x = id * 2;"
+       "    int y = x + 1;"
+       ""
+       "    float influenceSum = 0.0;"
+       ""
+       "    for (int s = 0; s < count; s++) {"
+       "        int bmu_x = bmuIndices[s] * 2;"
+       "        int bmu_y = bmu_x + 1;"
+       ""
+       "        float distance = (points[bmu_x] - points[x]) * (points[bmu_x] - points[x]) + (points[bmu_y] - points[y]) * (points[bmu_y] - points[y]);"
+       "        float squareNeighbourhood = schedule[s * 2] * schedule[s * 2];"
+       ""
+       "        if (distance <= squareNeighbourhood) {"
+       "            influenceSum += schedule[s * 2 + 1] * fmax(influence(distance, squareNeighbourhood, function), 0.0f);"
+       "        }"
+       "    }"
+       ""
+       "    if (influenceSum <= 0.0f) {"
+       "        return;"
+       "    }"
+       ""
+       "    float step = fmin(influenceSum, 1.0f);"
+       "    float meanScale = step / influenceSum;"
+       ""
+       "    for (int i = 0; i < vecSize; i++) {"
+       "        weights[id * nodeStride + i * channelStride] *= 1.0f - step;"
+       "    }"
+       ""
+       "    for (int s = 0; s < count; s++) {"
+       "        int bmu_x = bmuIndices[s] * 2;"
+       "        int bmu_y = bmu_x + 1;"
+       ""
+       "        float distance = (points[bmu_x] - points[x]) * (points[bmu_x] - points[x]) + (points[bmu_y] - points[y]) * (points[bmu_y] - points[y]);"
+       "        float squareNeighbourhood = schedule[s * 2] * schedule[s * 2];"
+       ""
+       "        if (distance <= squareNeighbourhood) {"
+       "            float nodeInfluence = meanScale * schedule[s * 2 + 1] * fmax(influence(distance, squareNeighbourhood, function), 0.0f);"
+       ""
+       "            for (int i = 0; i < vecSize; i++) {"
+       "                weights[id * nodeStride + i * channelStride] += nodeInfluence * inputVectors[s * vecSize + i];"
+       "            }"
+       "        }"
+       "    }"
+       "}", "updateWeights", context, commandQueue, deviceId),
+miniBatchKernel_(nullptr),
+tableKernel_(nullptr),
+stencilKernel_(nullptr),
+neighbourhood_(nullptr),
+neighboursBuffer_(nullptr),
+neighbourDistancesBuffer_(nullptr),
+lookupBuffer_(nullptr) {
+    miniBatchKernel_ = clCreateKernel(program_, "updateWeightsMiniBatch", nullptr);
+    tableKernel_ = clCreateKernel(program_, "updateWeightsTable", nullptr);
+    stencilKernel_ = clCreateKernel(program_, "updateWeightsStencil", nullptr);
+}
+
+WeightUpdateKernel::~WeightUpdateKernel() {
+    clReleaseKernel(miniBatchKernel_);
+    clReleaseKernel(tableKernel_);
+    clReleaseKernel(stencilKernel_);
+    
+    if (neighboursBuffer_) { clReleaseMemObject(neighboursBuffer_); }
+    if (neighbourDistancesBuffer_) { clReleaseMemObject(neighbourDistancesBuffer_); }
+    if (lookupBuffer_) { clReleaseMemObject(lookupBuffer_); }
+}
+
+void WeightUpdateKernel::connect(const Model &model, const cl_mem &inputBuffer, const cl_mem &weightsBuffer, const cl_mem &pointsBuffer, const WeightsLayout layout) {
+    inputBuffer_ = inputBuffer;
+    weightsBuffer_ = weightsBuffer;
+    pointsBuffer_ = pointsBuffer;
+    
+    channels_ = (cl_uint)model.getChannelsCount();
+    
+    clSetKernelArg(kernel_, 0, sizeof(cl_mem), &inputBuffer_);
+    clSetKernelArg(kernel_, 1, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(kernel_, 2, sizeof(cl_mem), &pointsBuffer_);
+    clSetKernelArg(kernel_, 3, sizeof(cl_uint), &channels_);
+    
+    clSetKernelArg(miniBatchKernel_, 1, sizeof(cl_mem), &weightsBuffer_);
+    clSetKernelArg(miniBatchKernel_, 2, sizeof(cl_mem), &pointsBuffer_);
+    clSetKernelArg(miniBatchKernel_, 3, sizeof(cl_uint), &channels_);
+    
+    for (auto kernel : {tableKernel_, stencilKernel_}) {
+        clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffer_);
+        clSetKernelArg(kernel, 1, sizeof(cl_mem), &weightsBuffer_);
+        clSetKernelArg(kernel, 2, sizeof(cl_uint), &channels_);
+    }
+    
+    cl_uint nodeStride = layout == CHANNEL_MAJOR ? 1 : channels_;
+    cl_uint channelStride = layout == CHANNEL_MAJOR ? (cl_uint)model.getNodesCount() : 1;
+    
+    clSetKernelArg(kernel_, 7, sizeof(cl_uint), &nodeStride);
+    clSetKernelArg(kernel_, 8, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(miniBatchKernel_, 7, sizeof(cl_uint), &nodeStride);
+    clSetKernelArg(miniBatchKernel_, 8, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(tableKernel_, 8, sizeof(cl_uint), &nodeStride);
+    clSetKernelArg(tableKernel_, 9, sizeof(cl_uint), &channelStride);
+    clSetKernelArg(stencilKernel_, 12, sizeof(cl_uint), &nodeStride);
+    clSetKernelArg(stencilKernel_, 13, sizeof(cl_uint), &channelStride);
+    
+    nodesCount_ = model.getNodesCount();
+    
+    setNodesRange(0, nodesCount_);
+}
+
+void WeightUpdateKernel::setNodesRange(const size_t begin, const size_t end) {
+    globalWorkOffset_[0] = begin;
+    globalWorkSize_[0] = end - begin;
+    
+    // The table rows and the stencil reach nodes anywhere on the map, the ones of the other shards are skipped
+    cl_uint nodesBegin = (cl_uint)begin;
+    cl_uint nodesEnd = (cl_uint)end;
+    
+    clSetKernelArg(tableKernel_, 11, sizeof(cl_uint), &nodesBegin);
+    clSetKernelArg(tableKernel_, 12, sizeof(cl_uint), &nodesEnd);
+    clSetKernelArg(stencilKernel_, 15, sizeof(cl_uint), &nodesBegin);
+    clSetKernelArg(stencilKernel_, 16, sizeof(cl_uint), &nodesEnd);
+}
+
+void WeightUpdateKernel::connect(const Neighbourhood &neighbourhood) {
+    neighbourhood_ = &neighbourhood;
+    
+    // Table rows or the stencil, the node indices or the axial offsets next to their squared distances
+    vector<cl_int> neighbours;
+    vector<cl_float> distances;
+    
+    if (neighbourhood.hasTable()) {
+        for (auto &neighbour : neighbourhood.getTable()) {
+            neighbours.push_back((cl_int)neighbour.index);
+            distances.push_back(neighbour.squaredDistance);
+        }
+    } else {
+        for (auto &offset : neighbourhood.getStencil()) {
+            neighbours.push_back(offset.dq);
+            neighbours.push_back(offset.dr);
+            distances.push_back(offset.squaredDistance);
+        }
+        
+        auto &lookup = neighbourhood.getLookup();
+        lookupBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, lookup.size() * sizeof(cl_int), (void *)lookup.data(), nullptr);
+    }
+    
+    neighboursBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, neighbours.size() * sizeof(cl_int), neighbours.data(), nullptr);
+    neighbourDistancesBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, distances.size() * sizeof(cl_float), distances.data(), nullptr);
+    
+    clSetKernelArg(tableKernel_, 3, sizeof(cl_mem), &neighboursBuffer_);
+    clSetKernelArg(tableKernel_, 4, sizeof(cl_mem), &neighbourDistancesBuffer_);
+    
+    cl_int lookupCols = (cl_int)neighbourhood.getLookupCols();
+    cl_int lookupRows = (cl_int)neighbourhood.getLookupRows();
+    
+    clSetKernelArg(stencilKernel_, 3, sizeof(cl_mem), &neighboursBuffer_);
+    clSetKernelArg(stencilKernel_, 4, sizeof(cl_mem), &neighbourDistancesBuffer_);
+    clSetKernelArg(stencilKernel_, 5, sizeof(cl_mem), &lookupBuffer_);
+    clSetKernelArg(stencilKernel_, 6, sizeof(cl_int), &lookupCols);
+    clSetKernelArg(stencilKernel_, 7, sizeof(cl_int), &lookupRows);
+}
+
+bool WeightUpdateKernel::isNeighbourhoodConnected() const {
+    return neighbourhood_;
+}
+
+void WeightUpdateKernel::compute(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius, const NeighbourhoodFunction function) {
+    cl_int clFunction = function;
+    cl_float clNeighbourhoodRadius = (cl_float)neighbourhoodRadius;
+    cl_float clLearningRate = (cl_float)learningRate;
+    cl_float clCutoffRadius = (cl_float)min(neighbourhoodRadius, cutoffRadius);
+    
+    // Only the nodes inside the cutoff radius, unless the stencil prefix is longer than the map
+    size_t count = neighbourhood_ ? neighbourhood_->prefixLength(bmuIndex, clCutoffRadius) : nodesCount_ + 1;
+    size_t globalWorkSize[1] = {count};
+    
+    if (count == 0) {
+        return;
+    }
+    
+    if (count <= nodesCount_ && neighbourhood_->hasTable()) {
+        cl_uint rowOffset = (cl_uint)(bmuIndex * nodesCount_);
+        
+        clSetKernelArg(tableKernel_, 5, sizeof(cl_uint), &rowOffset);
+        clSetKernelArg(tableKernel_, 6, sizeof(cl_float), &clNeighbourhoodRadius);
+        clSetKernelArg(tableKernel_, 7, sizeof(cl_float), &clLearningRate);
+        clSetKernelArg(tableKernel_, 10, sizeof(cl_int), &clFunction);
+        
+        clEnqueueNDRangeKernel(commandQueue_, tableKernel_, 1, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+    } else if (count <= nodesCount_) {
+        auto &coordinates = neighbourhood_->getCoordinates();
+        cl_int bmuCol = coordinates[bmuIndex * 2];
+        cl_int bmuRow = coordinates[bmuIndex * 2 + 1];
+        
+        clSetKernelArg(stencilKernel_, 8, sizeof(cl_int), &bmuCol);
+        clSetKernelArg(stencilKernel_, 9, sizeof(cl_int), &bmuRow);
+        clSetKernelArg(stencilKernel_, 10, sizeof(cl_float), &clNeighbourhoodRadius);
+        clSetKernelArg(stencilKernel_, 11, sizeof(cl_float), &clLearningRate);
+        clSetKernelArg(stencilKernel_, 14, sizeof(cl_int), &clFunction);
+        
+        clEnqueueNDRangeKernel(commandQueue_, stencilKernel_, 1, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+    } else {
+        cl_uint clBmuIndex = (cl_uint)bmuIndex;
+        
+        clSetKernelArg(kernel_, 4, sizeof(cl_uint), &clBmuIndex);
+        clSetKernelArg(kernel_, 5, sizeof(cl_float), &clNeighbourhoodRadius);
+        clSetKernelArg(kernel_, 6, sizeof(cl_float), &clLearningRate);
+        clSetKernelArg(kernel_, 9, sizeof(cl_float), &clCutoffRadius);
+        clSetKernelArg(kernel_, 10, sizeof(cl_int), &clFunction);
+        
+        clEnqueueNDRangeKernel(commandQueue_, kernel_, 1, globalWorkOffset_, globalWorkSize_, nullptr, 0, nullptr, nullptr);
+    }
+}
+
+void WeightUpdateKernel::computeMiniBatch(const cl_mem &inputVectorsBuffer, const cl_mem &bmuIndicesBuffer, const cl_mem &scheduleBuffer, const size_t count, const NeighbourhoodFunction function, cl_event *event) {
+    cl_uint clCount = (cl_uint)count;
+    cl_int clFunction = function;
+    
+    clSetKernelArg(miniBatchKernel_, 0, sizeof(cl_mem), &inputVectorsBuffer);
+    clSetKernelArg(miniBatchKernel_, 4, sizeof(cl_mem), &bmuIndicesBuffer);
+    clSetKernelArg(miniBatchKernel_, 5, sizeof(cl_mem), &scheduleBuffer);
+    clSetKernelArg(miniBatchKernel_, 6, sizeof(cl_uint), &clCount);
+    clSetKernelArg(miniBatchKernel_, 9, sizeof(cl_int), &clFunction);
+    
+    clEnqueueNDRangeKernel(commandQueue_, miniBatchKernel_, 1, globalWorkOffset_, globalWorkSize_, nullptr, 0, nullptr, event);
+}
@@ -0,0 +1,148 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstring>
+#include "model_pack.hpp"
+#include "model.hpp"
+#include "runtime.hpp"
+#include "native_kernels.hpp"
+#include "weight_distance_kernels.hpp"
+
+using namespace std;
+using namespace som;
+
+ModelPack::ModelPack(const vector<const Model *> &models, cl_device_id deviceId) :
+models_(models),
+channels_(0),
+metric_(EUCLIDEAN),
+deviceId_(deviceId),
+context_(nullptr),
+commandQueue_(nullptr),
+kernel_(nullptr),
+weightsBuffer_(nullptr),
+offsetsBuffer_(nullptr),
+vectorsBuffer_(nullptr),
+modelsBuffer_(nullptr),
+bmuIndicesBuffer_(nullptr),
+capacity_(0) {
+    assert(!models_.empty());
+    
+    channels_ = models_[0]->getChannelsCount();
+    metric_ = models_[0]->getMetric();
+    
+    offsets_.push_back(0);
+    
+    for (auto &model : models_) {
+        assert(model->getChannelsCount() == channels_ && model->getMetric() == metric_);
+        
+        offsets_.push_back(offsets_.back() + (cl_uint)model->getNodesCount());
+    }
+    
+    weights_.resize(offsets_.back() * channels_);
+    
+    if (deviceId_) {
+        context_ = Runtime::shared().context(deviceId_);
+        clRetainContext(context_);
+        
+        commandQueue_ = clCreateCommandQueue(context_, deviceId_, 0, nullptr);
+        
+        cl_device_type type = CL_DEVICE_TYPE_CPU;
+        clGetDeviceInfo(deviceId_, CL_DEVICE_TYPE, sizeof(cl_device_type), &type, nullptr);
+        
+        // The same program as the node-major models of these channels
+        auto options = WeightDistanceKernel::buildOptions(channels_, NODE_MAJOR);
+        kernel_ = WeightDistanceKernels::create(metric_, context_, commandQueue_, deviceId_, options, type & CL_DEVICE_TYPE_GPU ? GPU : CPU);
+        
+        weightsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, weights_.size() * sizeof(cl_float), nullptr, nullptr);
+        offsetsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, offsets_.size() * sizeof(cl_uint), offsets_.data(), nullptr);
+    }
+    
+    update();
+}
+
+ModelPack::~ModelPack() {
+    delete kernel_;
+    
+    if (weightsBuffer_) { clReleaseMemObject(weightsBuffer_); }
+    if (offsetsBuffer_) { clReleaseMemObject(offsetsBuffer_); }
+    if (vectorsBuffer_) { clReleaseMemObject(vectorsBuffer_); }
+    if (modelsBuffer_) { clReleaseMemObject(modelsBuffer_); }
+    if (bmuIndicesBuffer_) { clReleaseMemObject(bmuIndicesBuffer_); }
+    
+    if (commandQueue_) { clReleaseCommandQueue(commandQueue_); }
+    if (context_) { clReleaseContext(context_); }
+}
+
+void ModelPack::update() {
+    for (auto i = 0; i < models_.size(); i++) {
+        memcpy(&weights_[offsets_[i] * channels_], &models_[i]->getWeights(), models_[i]->getNodesCount() * channels_ * sizeof(cl_float));
+    }
+    
+    if (weightsBuffer_) {
+        clEnqueueWriteBuffer(commandQueue_, weightsBuffer_, CL_TRUE, 0, weights_.size() * sizeof(cl_float), weights_.data(), 0, nullptr, nullptr);
+    }
+}
+
+void ModelPack::reserve(const size_t count) {
+    if (count <= capacity_) {
+        return;
+    }
+    
+    if (vectorsBuffer_) { clReleaseMemObject(vectorsBuffer_); }
+    if (modelsBuffer_) { clReleaseMemObject(modelsBuffer_); }
+    if (bmuIndicesBuffer_) { clReleaseMemObject(bmuIndicesBuffer_); }
+    
+    vectorsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, count * channels_ * sizeof(cl_float), nullptr, nullptr);
+    modelsBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, count * sizeof(cl_uint), nullptr, nullptr);
+    bmuIndicesBuffer_ = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, count * sizeof(cl_uint), nullptr, nullptr);
+    
+    capacity_ = count;
+}
+
+void ModelPack::bmuIndices(const cl_float &vectors, const cl_uint *models, const size_t count, size_t *bmuIndices) {
+    const cl_float *data = &vectors;
+    
+    if (count == 0) {
+        return;
+    }
+    
+    if (!kernel_) {
+        auto bmu = nativeKernels().bmu[metric_];
+        
+        for (auto i = 0; i < count; i++) {
+            cl_float distance;
+            auto index = bmu(&data[i * channels_], weights_.data(), channels_, offsets_[models[i]], offsets_[models[i] + 1], distance);
+            
+            // No distance below FLT_MAX, like the device search
+            bmuIndices[i] = index == SIZE_MAX ? 0 : index - offsets_[models[i]];
+        }
+        
+        return;
+    }
+    
+    reserve(count);
+    
+    vector<cl_uint> indices(count);
+    
+    clEnqueueWriteBuffer(commandQueue_, vectorsBuffer_, CL_FALSE, 0, count * channels_ * sizeof(cl_float), data, 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(commandQueue_, modelsBuffer_, CL_FALSE, 0, count * sizeof(cl_uint), models, 0, nullptr, nullptr);
+    
+    kernel_->computePackedBmuIndices(vectorsBuffer_, weightsBuffer_, offsetsBuffer_, modelsBuffer_, bmuIndicesBuffer_, count);
+    
+    clEnqueueReadBuffer(commandQueue_, bmuIndicesBuffer_, CL_TRUE, 0, count * sizeof(cl_uint), indices.data(), 0, nullptr, nullptr);
+    
+    for (auto i = 0; i < count; i++) {
+        bmuIndices[i] = indices[i];
+    }
+}
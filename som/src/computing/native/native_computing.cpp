@@ -0,0 +1,519 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "native_computing.hpp"
+#include "native_kernels.hpp"
+#include "thread_pool.hpp"
+#include "model.hpp"
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <mutex>
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Distance evaluations per thread below which splitting the work doesn't pay off
+    static const size_t MIN_TASK_SIZE = 16384;
+    
+    static void mergeBmu(size_t &index, cl_float &distance, const size_t otherIndex, const cl_float otherDistance) {
+        if (otherDistance < distance || (otherDistance == distance && otherIndex < index)) {
+            index = otherIndex;
+            distance = otherDistance;
+        }
+    }
+}
+
+NativeComputing::NativeComputing(Model &model) :
+Computing(model),
+kernels_(nativeKernels()),
+threadPool_(ThreadPool::shared()),
+input_(model.getChannelsCount()),
+pointDistances_(model.getNodesCount()),
+distancesOutdated_(true),
+partialDistanceSearch_(true),
+lastBmuIndex_(0),
+influenceTable_(nullptr) {}
+
+NativeComputing::~NativeComputing() {
+    delete influenceTable_;
+}
+
+size_t NativeComputing::nodesGrain() const {
+    return max((size_t)1, MIN_TASK_SIZE / model_.getChannelsCount());
+}
+
+const char * NativeComputing::getInstructionSet() const {
+    return kernels_.name;
+}
+
+void NativeComputing::setPartialDistanceSearch(const bool enabled) {
+    partialDistanceSearch_ = enabled;
+}
+
+NativeBmuFunction NativeComputing::boundedBmu() const {
+    return partialDistanceSearch_ ? kernels_.boundedBmu[model_.getMetric()] : nullptr;
+}
+
+#pragma mark - BMU
+
+size_t NativeComputing::bmuIndex(const cl_float &inputVector, bool accumulateDistances, cl_float &distance) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    auto metric = model_.getMetric();
+    
+    cl_float *weights = &model_.getWeights();
+    cl_float *distances = &model_.getDistances();
+    cl_float *distancesAccumulator = &model_.getDistancesAccumulator();
+    
+    memcpy(input_.data(), &inputVector, sizeof(cl_float) * channels);
+    
+    mutex bmuMutex;
+    size_t index = SIZE_MAX;
+    distance = FLT_MAX;
+    
+    auto bounded = accumulateDistances ? nullptr : boundedBmu();
+    
+    // The distance to the previous BMU bounds the search
+    if (bounded) {
+        auto seed = min(lastBmuIndex_, nodesCount - 1);
+        
+        index = kernels_.bmu[metric](input_.data(), weights, channels, seed, seed + 1, distance);
+        bounded = index == SIZE_MAX ? nullptr : bounded;
+    }
+    
+    threadPool_.parallelFor(nodesCount, nodesGrain(), [&](size_t begin, size_t end) {
+        size_t rangeIndex;
+        cl_float rangeDistance;
+        
+        if (bounded) {
+            // The bound tightens as the other ranges merge their results
+            {
+                unique_lock<mutex> lock(bmuMutex);
+                rangeDistance = distance;
+            }
+            
+            rangeIndex = bounded(input_.data(), weights, channels, begin, end, rangeDistance);
+        } else if (accumulateDistances) {
+            // All the distances are needed, the argmin is taken over them
+            kernels_.distances[metric](input_.data(), weights, channels, begin, end, distances);
+            
+            rangeIndex = SIZE_MAX;
+            rangeDistance = FLT_MAX;
+            
+            for (auto i = begin; i < end; i++) {
+                if (distances[i] > 0.0) {
+                    distancesAccumulator[i] += distances[i];
+                }
+                
+                if (distances[i] < rangeDistance) {
+                    rangeDistance = distances[i];
+                    rangeIndex = i;
+                }
+            }
+        } else {
+            rangeIndex = kernels_.bmu[metric](input_.data(), weights, channels, begin, end, rangeDistance);
+        }
+        
+        unique_lock<mutex> lock(bmuMutex);
+        mergeBmu(index, distance, rangeIndex, rangeDistance);
+    });
+    
+    distancesOutdated_ = !accumulateDistances;
+    lastBmuIndex_ = index == SIZE_MAX ? 0 : index;
+    
+    return lastBmuIndex_;
+}
+
+void NativeComputing::bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices) {
+    searchBmuIndices(vectors, count, bmuIndices, nullptr);
+}
+
+void NativeComputing::searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    auto bmu = kernels_.bmu[model_.getMetric()];
+    auto bounded = boundedBmu();
+    auto grain = max((size_t)1, MIN_TASK_SIZE / (nodesCount * channels));
+    
+    const cl_float *data = &vectors;
+    cl_float *weights = &model_.getWeights();
+    
+    threadPool_.parallelFor(count, grain, [&](size_t begin, size_t end) {
+        cl_float distance;
+        
+        // Seeded with the BMU of the previous vector of the range, neighbouring vectors tend to share it
+        size_t seed = min(lastBmuIndex_, nodesCount - 1);
+        
+        for (auto i = begin; i < end; i++) {
+            const cl_float *vector = &data[i * channels];
+            
+            auto index = bounded ? bmu(vector, weights, channels, seed, seed + 1, distance) : SIZE_MAX;
+            
+            // The seed is within its own bound, so the bounded search over all the nodes finds the BMU
+            if (index != SIZE_MAX) {
+                index = bounded(vector, weights, channels, 0, nodesCount, distance);
+            } else {
+                index = bmu(vector, weights, channels, 0, nodesCount, distance);
+            }
+            
+            bmuIndices[i] = seed = index == SIZE_MAX ? 0 : index;
+            
+            if (distances) {
+                distances[i] = index == SIZE_MAX ? FLT_MAX : distance;
+            }
+        }
+    });
+}
+
+void NativeComputing::topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    auto function = kernels_.distances[model_.getMetric()];
+    auto grain = max((size_t)1, MIN_TASK_SIZE / (nodesCount * channels));
+    
+    const cl_float *data = &vectors;
+    cl_float *weights = &model_.getWeights();
+    
+    threadPool_.parallelFor(count, grain, [&](size_t begin, size_t end) {
+        vector<cl_float> nodeDistances(nodesCount);
+        vector<size_t> order(nodesCount);
+        
+        for (auto i = begin; i < end; i++) {
+            function(&data[i * channels], weights, channels, 0, nodesCount, nodeDistances.data());
+            
+            iota(order.begin(), order.end(), 0);
+            partial_sort(order.begin(), order.begin() + k, order.end(), [&](size_t a, size_t b) {
+                return nodeDistances[a] < nodeDistances[b] || (nodeDistances[a] == nodeDistances[b] && a < b);
+            });
+            
+            for (auto j = 0; j < k; j++) {
+                indices[i * k + j] = order[j];
+                distances[i * k + j] = nodeDistances[order[j]];
+            }
+        }
+    });
+}
+
+bool NativeComputing::nodeDistances(const cl_float &inputVector, const cl_uint *nodes, const size_t count, cl_float *distances) {
+    auto channels = model_.getChannelsCount();
+    auto function = kernels_.distances[model_.getMetric()];
+    
+    cl_float *weights = &model_.getWeights();
+    cl_float *nodeDistances = &model_.getDistances();
+    
+    memcpy(input_.data(), &inputVector, sizeof(cl_float) * channels);
+    
+    // Too few nodes to share, the Model distances serve as the scratch
+    for (auto i = 0; i < count; i++) {
+        function(input_.data(), weights, channels, nodes[i], nodes[i] + 1, nodeDistances);
+        distances[i] = nodeDistances[nodes[i]];
+    }
+    
+    distancesOutdated_ = true;
+    
+    return true;
+}
+
+cl_float & NativeComputing::weightDistances() {
+    cl_float *distances = &model_.getDistances();
+    
+    if (distancesOutdated_) {
+        auto channels = model_.getChannelsCount();
+        auto function = kernels_.distances[model_.getMetric()];
+        
+        cl_float *weights = &model_.getWeights();
+        
+        threadPool_.parallelFor(model_.getNodesCount(), nodesGrain(), [&](size_t begin, size_t end) {
+            function(input_.data(), weights, channels, begin, end, distances);
+        });
+        
+        distancesOutdated_ = false;
+    }
+    
+    return distances[0];
+}
+
+#pragma mark - Training
+
+void NativeComputing::adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius) {
+    auto channels = model_.getChannelsCount();
+    
+    cl_float *weights = &model_.getWeights();
+    
+    auto &neighbourhood = model_.getNeighbourhood();
+    
+    if (!influenceTable_) {
+        influenceTable_ = new InfluenceTable(neighbourhood);
+    }
+    
+    auto &influences = *influenceTable_;
+    influences.update(model_.getNeighbourhoodFunction(), neighbourhoodRadius);
+    
+    // Only the nodes inside the radius are visited, which are a few late in the training
+    neighbours_.clear();
+    neighbourhood.visit(bmuIndex, min(neighbourhoodRadius, cutoffRadius), [&](cl_uint index, cl_float squaredDistance) {
+        neighbours_.push_back({index, squaredDistance});
+    });
+    
+    threadPool_.parallelFor(neighbours_.size(), nodesGrain(), [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            // The negative ring of the Mexican hat would push the nodes out of the data, it's clamped like in the batch step
+            float influence = learningRate * max(influences(neighbours_[i].squaredDistance), 0.0f);
+            
+            for (auto j = 0; j < channels; j++) {
+                auto index = neighbours_[i].index * channels + j;
+                
+                weights[index] += influence * (input_[j] - weights[index]);
+            }
+        }
+    });
+    
+    distancesOutdated_ = true;
+}
+
+void NativeComputing::adjustWeightsBatch(const double neighbourhoodRadius) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    auto count = model_.getDataCount();
+    
+    cl_float *weights = &model_.getWeights();
+    cl_float *data = &model_.getData();
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    vector<size_t> bmus(count);
+    bmuIndices(data[0], count, bmus.data());
+    
+    vector<double> clusterSums(nodesCount * channels, 0);
+    vector<size_t> clusterCounts(nodesCount, 0);
+    mutex clustersMutex;
+    
+    // Every range sums its vectors on its own, the sums are merged once per range. A range covers at least
+    // as many vectors as there are nodes, so its sums cost no more than its vectors.
+    auto grain = max(nodesCount, MIN_TASK_SIZE / channels);
+    
+    threadPool_.parallelFor(count, grain, [&](size_t begin, size_t end) {
+        vector<double> rangeSums(nodesCount * channels, 0);
+        vector<size_t> rangeCounts(nodesCount, 0);
+        
+        for (auto i = begin; i < end; i++) {
+            auto bmu = bmus[i];
+            
+            rangeCounts[bmu]++;
+            
+            for (auto j = 0; j < channels; j++) {
+                rangeSums[bmu * channels + j] += data[i * channels + j];
+            }
+        }
+        
+        unique_lock<mutex> lock(clustersMutex);
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            if (rangeCounts[i] == 0) {
+                continue;
+            }
+            
+            clusterCounts[i] += rangeCounts[i];
+            
+            for (auto j = 0; j < channels; j++) {
+                clusterSums[i * channels + j] += rangeSums[i * channels + j];
+            }
+        }
+    });
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        activationStates[i] += clusterCounts[i];
+    }
+    
+    float squareNeighbourhood = neighbourhoodRadius * neighbourhoodRadius;
+    auto function = model_.getNeighbourhoodFunction();
+    auto &neighbourhood = model_.getNeighbourhood();
+    
+    // Only the nodes within the radius are visited, and only those with vectors contribute
+    threadPool_.parallelFor(nodesCount, nodesGrain(), [&](size_t begin, size_t end) {
+        vector<double> weightedSum(channels);
+        
+        for (auto i = begin; i < end; i++) {
+            double influenceSum = 0;
+            fill(weightedSum.begin(), weightedSum.end(), 0);
+            
+            neighbourhood.visit(i, neighbourhoodRadius, [&](cl_uint k, cl_float distance) {
+                if (clusterCounts[k] == 0) {
+                    return;
+                }
+                
+                double influence = max(InfluenceTable::influence(function, distance, squareNeighbourhood), 0.0f);
+                
+                influenceSum += influence * clusterCounts[k];
+                
+                for (auto j = 0; j < channels; j++) {
+                    weightedSum[j] += influence * clusterSums[k * channels + j];
+                }
+            });
+            
+            if (influenceSum > 0) {
+                for (auto j = 0; j < channels; j++) {
+                    weights[i * channels + j] = weightedSum[j] / influenceSum;
+                }
+            }
+        }
+    });
+    
+    distancesOutdated_ = true;
+}
+
+void NativeComputing::adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    
+    const cl_float *data = &vectors;
+    const cl_float *radiuses = &schedule;
+    cl_float *weights = &model_.getWeights();
+    cl_float *points = &model_.getPoints();
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    auto function = model_.getNeighbourhoodFunction();
+    
+    vector<size_t> bmus(count);
+    bmuIndices(vectors, count, bmus.data());
+    
+    for (auto i = 0; i < count; i++) {
+        activationStates[bmus[i]]++;
+    }
+    
+    // The updates of all the vectors are taken against the weights before the step
+    threadPool_.parallelFor(nodesCount, max((size_t)1, MIN_TASK_SIZE / (count * channels)), [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            float influenceSum = 0;
+            
+            for (auto s = 0; s < count; s++) {
+                auto bmu = bmus[s];
+                float distance = (points[bmu * 2] - points[i * 2]) * (points[bmu * 2] - points[i * 2]) + (points[bmu * 2 + 1] - points[i * 2 + 1]) * (points[bmu * 2 + 1] - points[i * 2 + 1]);
+                float squareNeighbourhood = radiuses[s * 2] * radiuses[s * 2];
+                
+                if (distance <= squareNeighbourhood) {
+                    influenceSum += radiuses[s * 2 + 1] * max(InfluenceTable::influence(function, distance, squareNeighbourhood), 0.0f);
+                }
+            }
+            
+            if (influenceSum <= 0) {
+                continue;
+            }
+            
+            // The node moves towards the influence-weighted mean of the batch, by at most the whole way
+            float step = min(influenceSum, 1.0f);
+            float meanScale = step / influenceSum;
+            
+            for (auto j = 0; j < channels; j++) {
+                weights[i * channels + j] *= 1.0f - step;
+            }
+            
+            for (auto s = 0; s < count; s++) {
+                auto bmu = bmus[s];
+                float distance = (points[bmu * 2] - points[i * 2]) * (points[bmu * 2] - points[i * 2]) + (points[bmu * 2 + 1] - points[i * 2 + 1]) * (points[bmu * 2 + 1] - points[i * 2 + 1]);
+                float squareNeighbourhood = radiuses[s * 2] * radiuses[s * 2];
+                
+                if (distance <= squareNeighbourhood) {
+                    float influence = meanScale * radiuses[s * 2 + 1] * max(InfluenceTable::influence(function, distance, squareNeighbourhood), 0.0f);
+                    
+                    for (auto j = 0; j < channels; j++) {
+                        weights[i * channels + j] += influence * data[s * channels + j];
+                    }
+                }
+            }
+        }
+    });
+    
+    distancesOutdated_ = true;
+}
+
+#pragma mark - Error
+
+void NativeComputing::errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum) {
+    auto channels = model_.getChannelsCount();
+    auto nodesCount = model_.getNodesCount();
+    auto function = kernels_.distances[model_.getMetric()];
+    auto grain = max((size_t)1, MIN_TASK_SIZE / (nodesCount * channels));
+    
+    const cl_float *data = &vectors;
+    cl_float *weights = &model_.getWeights();
+    cl_float *points = &model_.getPoints();
+    cl_float maxAdjacentDistance = 2 * model_.getNeighbourhood().getSquaredSpacing();
+    
+    mutex sumsMutex;
+    
+    distancesSum = 0;
+    topographicErrorsSum = 0;
+    
+    threadPool_.parallelFor(count, grain, [&](size_t begin, size_t end) {
+        vector<cl_float> distances(nodesCount);
+        double localDistancesSum = 0;
+        double localErrorsSum = 0;
+        
+        for (auto i = begin; i < end; i++) {
+            function(&data[i * channels], weights, channels, 0, nodesCount, distances.data());
+            
+            // The BMU and the second BMU, ties resolve to the lowest index
+            cl_float lowestDistance = FLT_MAX, secondDistance = FLT_MAX;
+            size_t bmu = SIZE_MAX, second = SIZE_MAX;
+            
+            for (auto j = 0; j < nodesCount; j++) {
+                if (distances[j] < lowestDistance) {
+                    secondDistance = lowestDistance;
+                    second = bmu;
+                    lowestDistance = distances[j];
+                    bmu = j;
+                } else if (distances[j] < secondDistance) {
+                    secondDistance = distances[j];
+                    second = j;
+                }
+            }
+            
+            if (bmu == SIZE_MAX) {
+                continue;
+            }
+            
+            localDistancesSum += lowestDistance;
+            
+            if (second != SIZE_MAX) {
+                auto dx = points[bmu * 2] - points[second * 2];
+                auto dy = points[bmu * 2 + 1] - points[second * 2 + 1];
+                
+                localErrorsSum += dx * dx + dy * dy > maxAdjacentDistance ? 1 : 0;
+            }
+        }
+        
+        unique_lock<mutex> lock(sumsMutex);
+        
+        distancesSum += localDistancesSum;
+        topographicErrorsSum += localErrorsSum;
+    });
+}
+
+#pragma mark - Topological distances
+
+cl_float & NativeComputing::pointDistances(const size_t index) {
+    model_.getNeighbourhood().squaredDistances(index, pointDistances_.data());
+    
+    return pointDistances_[0];
+}
+
+#pragma mark - Synchronization
+
+void NativeComputing::readModel() {}
+
+void NativeComputing::writeModel() {
+    distancesOutdated_ = true;
+}
@@ -0,0 +1,93 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "native_kernels.hpp"
+#include <math.h>
+
+#define NATIVE_ISA scalar
+
+namespace som {
+    
+    namespace scalar {
+        
+        struct Vector {
+            typedef float type;
+            
+            static const size_t width = 1;
+            
+            static type zero() { return 0; }
+            static type load(const float *p) { return *p; }
+            static type loadPartial(const float *p, const size_t count, const float fill) { return *p; }
+            
+            static type add(const type a, const type b) { return a + b; }
+            static type sub(const type a, const type b) { return a - b; }
+            static type mul(const type a, const type b) { return a * b; }
+            static type div(const type a, const type b) { return a / b; }
+            static type abs(const type a) { return fabsf(a); }
+            static type fmadd(const type a, const type b, const type c) { return a * b + c; }
+            
+            // NaN values are skipped, as by the OpenCL kernels
+            static type max(const type value, const type maximum) { return value > maximum ? value : maximum; }
+            
+            static float sum(const type a) { return a; }
+            static float maximum(const type a) { return a; }
+        };
+        
+    }
+    
+}
+
+#include "native_kernels_impl.hpp"
+
+using namespace som;
+
+namespace som {
+#if defined(SOM_NATIVE_AVX2)
+    namespace avx2 { const NativeKernels & instructionSetKernels(); }
+#endif
+    
+#if defined(SOM_NATIVE_AVX512)
+    namespace avx512 { const NativeKernels & instructionSetKernels(); }
+#endif
+}
+
+const NativeKernels & som::scalarKernels() {
+    static const NativeKernels kernels = scalar::kernels("Scalar");
+    
+    return kernels;
+}
+
+const NativeKernels * som::avx2Kernels() {
+#if defined(SOM_NATIVE_AVX2)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &avx2::instructionSetKernels();
+    }
+#endif
+    
+    return nullptr;
+}
+
+const NativeKernels * som::avx512Kernels() {
+#if defined(SOM_NATIVE_AVX512)
+    if (__builtin_cpu_supports("avx512f")) {
+        return &avx512::instructionSetKernels();
+    }
+#endif
+    
+    return nullptr;
+}
+
+const NativeKernels & som::nativeKernels() {
+    static const NativeKernels &kernels = avx512Kernels() ? *avx512Kernels() : avx2Kernels() ? *avx2Kernels() : scalarKernels();
+    
+    return kernels;
+}
@@ -0,0 +1,85 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "native_kernels.hpp"
+
+#if defined(SOM_NATIVE_AVX2)
+
+#include <immintrin.h>
+
+#define NATIVE_ISA avx2
+
+namespace som {
+    
+    namespace avx2 {
+        
+        const NativeKernels & instructionSetKernels();
+        
+        struct Vector {
+            typedef __m256 type;
+            
+            static const size_t width = 8;
+            
+            static type zero() { return _mm256_setzero_ps(); }
+            static type load(const float *p) { return _mm256_loadu_ps(p); }
+            
+            static type loadPartial(const float *p, const size_t count, const float fill) {
+                static const int32_t masks[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+                
+                auto mask = _mm256_loadu_si256((const __m256i *)&masks[width - count]);
+                
+                return _mm256_blendv_ps(_mm256_set1_ps(fill), _mm256_maskload_ps(p, mask), _mm256_castsi256_ps(mask));
+            }
+            
+            static type add(const type a, const type b) { return _mm256_add_ps(a, b); }
+            static type sub(const type a, const type b) { return _mm256_sub_ps(a, b); }
+            static type mul(const type a, const type b) { return _mm256_mul_ps(a, b); }
+            static type div(const type a, const type b) { return _mm256_div_ps(a, b); }
+            static type abs(const type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+            static type fmadd(const type a, const type b, const type c) { return _mm256_fmadd_ps(a, b, c); }
+            
+            // Returns the second operand for NaN values
+            static type max(const type value, const type maximum) { return _mm256_max_ps(value, maximum); }
+            
+            static float sum(const type a) {
+                auto sum = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+                
+                sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+                
+                return _mm_cvtss_f32(sum);
+            }
+            
+            static float maximum(const type a) {
+                auto maximum = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+                
+                maximum = _mm_max_ps(maximum, _mm_movehl_ps(maximum, maximum));
+                maximum = _mm_max_ss(maximum, _mm_shuffle_ps(maximum, maximum, 1));
+                
+                return _mm_cvtss_f32(maximum);
+            }
+        };
+        
+    }
+    
+}
+
+#include "native_kernels_impl.hpp"
+
+// Only called by the dispatcher after checking the CPU, nothing in this file may run before that
+const som::NativeKernels & som::avx2::instructionSetKernels() {
+    static const NativeKernels kernels = avx2::kernels("AVX2");
+    
+    return kernels;
+}
+
+#endif
@@ -0,0 +1,66 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "native_kernels.hpp"
+
+#if defined(SOM_NATIVE_AVX512)
+
+#include <immintrin.h>
+
+#define NATIVE_ISA avx512
+
+namespace som {
+    
+    namespace avx512 {
+        
+        const NativeKernels & instructionSetKernels();
+        
+        struct Vector {
+            typedef __m512 type;
+            
+            static const size_t width = 16;
+            
+            static type zero() { return _mm512_setzero_ps(); }
+            static type load(const float *p) { return _mm512_loadu_ps(p); }
+            
+            static type loadPartial(const float *p, const size_t count, const float fill) {
+                return _mm512_mask_loadu_ps(_mm512_set1_ps(fill), (__mmask16)((1u << count) - 1), p);
+            }
+            
+            static type add(const type a, const type b) { return _mm512_add_ps(a, b); }
+            static type sub(const type a, const type b) { return _mm512_sub_ps(a, b); }
+            static type mul(const type a, const type b) { return _mm512_mul_ps(a, b); }
+            static type div(const type a, const type b) { return _mm512_div_ps(a, b); }
+            static type abs(const type a) { return _mm512_abs_ps(a); }
+            static type fmadd(const type a, const type b, const type c) { return _mm512_fmadd_ps(a, b, c); }
+            
+            // Returns the second operand for NaN values
+            static type max(const type value, const type maximum) { return _mm512_max_ps(value, maximum); }
+            
+            static float sum(const type a) { return _mm512_reduce_add_ps(a); }
+            static float maximum(const type a) { return _mm512_reduce_max_ps(a); }
+        };
+        
+    }
+    
+}
+
+#include "native_kernels_impl.hpp"
+
+// Only called by the dispatcher after checking the CPU, nothing in this file may run before that
+const som::NativeKernels & som::avx512::instructionSetKernels() {
+    static const NativeKernels kernels = avx512::kernels("AVX-512");
+    
+    return kernels;
+}
+
+#endif
@@ -0,0 +1,137 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <memory>
+#include <assert.h>
+
+using namespace std;
+using namespace som;
+
+ThreadPool::ThreadPool(const size_t threadsCount) :
+stopping_(false) {
+    for (size_t i = 0; i < threadsCount; i++) {
+        threads_.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    
+    condition_.notify_all();
+    
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+ThreadPool & ThreadPool::shared() {
+    // The calling thread takes part in every task, so one thread less is spawned
+    static ThreadPool threadPool(max(1u, thread::hardware_concurrency()) - 1);
+    
+    return threadPool;
+}
+
+size_t ThreadPool::getThreadsCount() const {
+    return threads_.size() + 1;
+}
+
+#pragma mark - Tasks
+
+void ThreadPool::parallelFor(const size_t count, const size_t grain, const function<void(size_t begin, size_t end)> &task) {
+    auto rangesCount = min(getThreadsCount(), (count + max((size_t)1, grain) - 1) / max((size_t)1, grain));
+    
+    if (count == 0) {
+        return;
+    }
+    
+    if (rangesCount <= 1) {
+        task(0, count);
+        
+        return;
+    }
+    
+    auto rangeSize = (count + rangesCount - 1) / rangesCount;
+    
+    mutex doneMutex;
+    condition_variable doneCondition;
+    size_t remainingCount = rangesCount - 1;
+    
+    {
+        unique_lock<mutex> lock(mutex_);
+        
+        for (size_t i = 1; i < rangesCount; i++) {
+            auto begin = i * rangeSize;
+            auto end = min(count, begin + rangeSize);
+            
+            tasks_.push([&, begin, end] {
+                if (begin < end) {
+                    task(begin, end);
+                }
+                
+                unique_lock<mutex> doneLock(doneMutex);
+                
+                if (--remainingCount == 0) {
+                    doneCondition.notify_one();
+                }
+            });
+        }
+    }
+    
+    condition_.notify_all();
+    
+    task(0, min(count, rangeSize));
+    
+    unique_lock<mutex> doneLock(doneMutex);
+    doneCondition.wait(doneLock, [&] { return remainingCount == 0; });
+}
+
+future<void> ThreadPool::submit(function<void()> task) {
+    assert(!threads_.empty());
+    
+    // The queue holds copyable tasks, the packaged task is shared with it
+    auto packagedTask = make_shared<packaged_task<void()>>(move(task));
+    auto result = packagedTask->get_future();
+    
+    {
+        unique_lock<mutex> lock(mutex_);
+        tasks_.push([packagedTask] { (*packagedTask)(); });
+    }
+    
+    condition_.notify_one();
+    
+    return result;
+}
+
+void ThreadPool::work() {
+    while (true) {
+        function<void()> task;
+        
+        {
+            unique_lock<mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            
+            task = move(tasks_.front());
+            tasks_.pop();
+        }
+        
+        task();
+    }
+}
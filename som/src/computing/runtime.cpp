@@ -0,0 +1,93 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include "runtime.hpp"
+#include "program_cache.hpp"
+
+using namespace std;
+using namespace som;
+
+Runtime::Runtime() {}
+
+Runtime::~Runtime() {
+    for (auto &program : programs_) {
+        if (program.second.get()) { clReleaseProgram(program.second.get()); }
+    }
+    
+    for (auto &context : contexts_) {
+        clReleaseContext(context.second);
+    }
+}
+
+Runtime & Runtime::shared() {
+    static Runtime runtime;
+    
+    return runtime;
+}
+
+cl_context Runtime::context(const cl_device_id &deviceId) {
+    lock_guard<mutex> lock(mutex_);
+    
+    auto &context = contexts_[deviceId];
+    
+    if (!context) {
+        context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    }
+    
+    return context;
+}
+
+cl_program Runtime::program(const string &code, cl_context &context, cl_device_id &deviceId, const string &options) {
+    unique_lock<mutex> lock(mutex_);
+    
+    bool shared = false;
+    
+    for (auto &device : contexts_) {
+        shared = shared || device.second == context;
+    }
+    
+    if (!shared) {
+        lock.unlock();
+        
+        return ProgramCache::build(code, context, deviceId, options);
+    }
+    
+    // The options come first, they are short and tell most programs apart
+    auto key = make_pair(context, options + '\n' + code);
+    auto found = programs_.find(key);
+    
+    cl_program program = nullptr;
+    
+    if (found == programs_.end()) {
+        // The first caller builds, the others get the future in the meantime
+        promise<cl_program> built;
+        programs_[key] = built.get_future().share();
+        
+        lock.unlock();
+        
+        program = ProgramCache::build(code, context, deviceId, options);
+        built.set_value(program);
+    } else {
+        auto future = found->second;
+        
+        lock.unlock();
+        
+        program = future.get();
+    }
+    
+    if (program) {
+        clRetainProgram(program);
+    }
+    
+    return program;
+}
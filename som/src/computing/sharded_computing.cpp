@@ -0,0 +1,331 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include "sharded_computing.hpp"
+#include "cl_computing.hpp"
+#include "thread_pool.hpp"
+#include "model.hpp"
+#include "neighbourhood.hpp"
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Searches timed per device by balance(), after one that builds the kernels
+    static const size_t BALANCE_PROBES = 8;
+}
+
+ShardedComputing::ShardedComputing(Model &model, const vector<cl_device_id> &deviceIds) :
+Computing(model),
+pointDistances_(model.getNodesCount()) {
+    assert(!deviceIds.empty());
+    
+    auto nodesCount = model_.getNodesCount();
+    auto shardsCount = min(deviceIds.size(), nodesCount);
+    
+    // Equal ranges until the devices are timed
+    for (auto i = 0; i <= shardsCount; i++) {
+        bounds_.push_back(i * nodesCount / shardsCount);
+    }
+    
+    for (auto i = 0; i < shardsCount; i++) {
+        shards_.push_back(new CLComputing(model_, deviceIds[i], bounds_[i], bounds_[i + 1]));
+    }
+    
+    shardIndices_.resize(shardsCount);
+    shardDistances_.resize(shardsCount);
+    
+    balance();
+}
+
+ShardedComputing::~ShardedComputing() {
+    for (auto &shard : shards_) {
+        delete shard;
+    }
+}
+
+#pragma mark - Shards
+
+void ShardedComputing::balance() {
+    auto nodesCount = model_.getNodesCount();
+    auto shardsCount = shards_.size();
+    
+    vector<cl_float> probe(model_.getChannelsCount(), 0);
+    vector<double> throughputs(shardsCount);
+    double throughputsSum = 0;
+    
+    // The nodes of every shard reach the Model before the bounds move
+    readModel();
+    
+    // One device at a time, so they don't compete for the host
+    for (auto i = 0; i < shardsCount; i++) {
+        cl_float distance;
+        shards_[i]->bmuIndex(probe[0], false, distance);
+        
+        auto start = chrono::steady_clock::now();
+        
+        for (auto j = 0; j < BALANCE_PROBES; j++) {
+            shards_[i]->bmuIndex(probe[0], false, distance);
+        }
+        
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        
+        throughputs[i] = (bounds_[i + 1] - bounds_[i]) / max(elapsed.count(), 1e-9);
+        throughputsSum += throughputs[i];
+    }
+    
+    double cumulative = 0;
+    
+    // At least a node per shard
+    for (auto i = 1; i < shardsCount; i++) {
+        cumulative += throughputs[i - 1];
+        
+        auto bound = (size_t)round(cumulative / throughputsSum * nodesCount);
+        bounds_[i] = min(max(bound, bounds_[i - 1] + 1), nodesCount - (shardsCount - i));
+    }
+    
+    for (auto i = 0; i < shardsCount; i++) {
+        shards_[i]->setNodesRange(bounds_[i], bounds_[i + 1]);
+    }
+    
+    writeModel();
+}
+
+void ShardedComputing::forEachShard(const function<void(size_t shard)> &task) {
+    ThreadPool::shared().parallelFor(shards_.size(), 1, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            task(i);
+        }
+    });
+}
+
+size_t ShardedComputing::getShardsCount() const {
+    return shards_.size();
+}
+
+size_t ShardedComputing::getShardBegin(const size_t shard) const {
+    return bounds_[shard];
+}
+
+size_t ShardedComputing::getShardEnd(const size_t shard) const {
+    return bounds_[shard + 1];
+}
+
+#pragma mark - BMU
+
+size_t ShardedComputing::bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance) {
+    std::vector<size_t> indices(shards_.size());
+    std::vector<cl_float> distances(shards_.size());
+    
+    forEachShard([&](size_t shard) {
+        indices[shard] = shards_[shard]->bmuIndex(vector, accumulateDistances, distances[shard]);
+    });
+    
+    // The shards hold ascending ranges, a tie keeps the lowest index
+    size_t nearest = 0;
+    
+    for (auto i = 1; i < shards_.size(); i++) {
+        if (distances[i] < distances[nearest]) {
+            nearest = i;
+        }
+    }
+    
+    distance = distances[nearest];
+    
+    return indices[nearest];
+}
+
+void ShardedComputing::bmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices) {
+    vector<cl_float> distances(count);
+    
+    topK(vectors, count, 1, bmuIndices, distances.data());
+}
+
+void ShardedComputing::searchBmuIndices(const cl_float &vectors, const size_t count, size_t *bmuIndices, cl_float *distances) {
+    vector<vector<size_t>> indices(shards_.size(), vector<size_t>(count));
+    vector<vector<cl_float>> nearestDistances(shards_.size(), vector<cl_float>(count));
+    
+    forEachShard([&](size_t shard) {
+        shards_[shard]->searchBmuIndices(vectors, count, indices[shard].data(), nearestDistances[shard].data());
+    });
+    
+    for (auto i = 0; i < count; i++) {
+        size_t nearest = 0;
+        
+        for (auto shard = 1; shard < shards_.size(); shard++) {
+            if (nearestDistances[shard][i] < nearestDistances[nearest][i]) {
+                nearest = shard;
+            }
+        }
+        
+        bmuIndices[i] = indices[nearest][i];
+        
+        if (distances) {
+            distances[i] = nearestDistances[nearest][i];
+        }
+    }
+}
+
+void ShardedComputing::topK(const cl_float &vectors, const size_t count, const size_t k, size_t *indices, cl_float *distances) {
+    forEachShard([&](size_t shard) {
+        shardIndices_[shard].resize(count * k);
+        shardDistances_[shard].resize(count * k);
+        
+        shards_[shard]->topK(vectors, count, k, shardIndices_[shard].data(), shardDistances_[shard].data());
+    });
+    
+    mergeTopK(count, k, indices, distances);
+}
+
+void ShardedComputing::mergeTopK(const size_t count, const size_t k, size_t *indices, cl_float *distances) {
+    vector<size_t> heads(shards_.size());
+    
+    for (auto i = 0; i < count; i++) {
+        fill(heads.begin(), heads.end(), 0);
+        
+        for (auto j = 0; j < k; j++) {
+            size_t nearest = 0;
+            
+            for (auto shard = 1; shard < shards_.size(); shard++) {
+                if (shardDistances_[shard][i * k + heads[shard]] < shardDistances_[nearest][i * k + heads[nearest]]) {
+                    nearest = shard;
+                }
+            }
+            
+            indices[i * k + j] = shardIndices_[nearest][i * k + heads[nearest]];
+            distances[i * k + j] = shardDistances_[nearest][i * k + heads[nearest]];
+            
+            heads[nearest]++;
+        }
+    }
+}
+
+cl_float & ShardedComputing::weightDistances() {
+    forEachShard([&](size_t shard) {
+        shards_[shard]->weightDistances();
+    });
+    
+    return model_.getDistances();
+}
+
+#pragma mark - Training
+
+void ShardedComputing::adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius) {
+    forEachShard([&](size_t shard) {
+        shards_[shard]->adjustWeights(bmuIndex, neighbourhoodRadius, learningRate, cutoffRadius);
+    });
+}
+
+void ShardedComputing::adjustWeightsBatch(const double neighbourhoodRadius) {
+    auto count = model_.getDataCount();
+    vector<size_t> indices(count);
+    
+    bmuIndices(model_.getData(), count, indices.data());
+    
+    bmuIndices_.assign(indices.begin(), indices.end());
+    
+    forEachShard([&](size_t shard) {
+        shards_[shard]->adjustWeightsBatch(neighbourhoodRadius, bmuIndices_.data());
+    });
+    
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    for (auto &index : bmuIndices_) {
+        activationStates[index]++;
+    }
+}
+
+void ShardedComputing::adjustWeightsMiniBatch(const cl_float &vectors, const size_t count, const cl_float &schedule) {
+    vector<size_t> indices(count);
+    
+    bmuIndices(vectors, count, indices.data());
+    
+    bmuIndices_.assign(indices.begin(), indices.end());
+    
+    forEachShard([&](size_t shard) {
+        shards_[shard]->adjustWeightsMiniBatch(vectors, count, schedule, bmuIndices_.data());
+    });
+    
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    for (auto &index : bmuIndices_) {
+        activationStates[index]++;
+    }
+}
+
+void ShardedComputing::finish() {
+    forEachShard([&](size_t shard) {
+        shards_[shard]->finish();
+    });
+}
+
+#pragma mark - Error
+
+void ShardedComputing::errorSums(const cl_float &vectors, const size_t count, double &distancesSum, double &topographicErrorsSum) {
+    auto nodesCount = model_.getNodesCount();
+    
+    cl_float *points = &model_.getPoints();
+    cl_float maxAdjacentDistance = 2 * model_.getNeighbourhood().getSquaredSpacing();
+    
+    vector<size_t> indices(count * 2);
+    vector<cl_float> distances(count * 2);
+    
+    // The BMU and the second BMU of every vector
+    topK(vectors, count, 2, indices.data(), distances.data());
+    
+    distancesSum = 0;
+    topographicErrorsSum = 0;
+    
+    for (auto i = 0; i < count; i++) {
+        auto bmu = indices[i * 2];
+        auto second = indices[i * 2 + 1];
+        
+        if (bmu >= nodesCount) {
+            continue;
+        }
+        
+        distancesSum += distances[i * 2];
+        
+        if (second < nodesCount) {
+            cl_float dx = points[bmu * 2] - points[second * 2];
+            cl_float dy = points[bmu * 2 + 1] - points[second * 2 + 1];
+            
+            topographicErrorsSum += dx * dx + dy * dy > maxAdjacentDistance ? 1 : 0;
+        }
+    }
+}
+
+#pragma mark - Topological distances
+
+cl_float & ShardedComputing::pointDistances(const size_t index) {
+    model_.getNeighbourhood().squaredDistances(index, pointDistances_.data());
+    
+    return pointDistances_[0];
+}
+
+#pragma mark - Synchronization
+
+void ShardedComputing::readModel() {
+    forEachShard([&](size_t shard) {
+        shards_[shard]->readModel();
+    });
+}
+
+void ShardedComputing::writeModel() {
+    forEachShard([&](size_t shard) {
+        shards_[shard]->writeModel();
+    });
+}
@@ -0,0 +1,267 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include "frozen_som.hpp"
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <cstring>
+#include <fstream>
+#include "aligned_memory.hpp"
+#include "normalizer.hpp"
+#include "native_kernels.hpp"
+#include "thread_pool.hpp"
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Distance evaluations per thread below which splitting a batch doesn't pay off
+    static const size_t MIN_TASK_SIZE = 16384;
+    
+    static size_t cacheLines(const size_t size) {
+        return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    }
+}
+
+FrozenSOM::FrozenSOM() :
+nodesCount_(0),
+channels_(0),
+metric_(EUCLIDEAN),
+normalizer_(nullptr),
+memory_(nullptr),
+weights_(nullptr),
+labels_(nullptr),
+scales_(nullptr),
+offsets_(nullptr) {}
+
+FrozenSOM::~FrozenSOM() {
+    release();
+}
+
+void FrozenSOM::allocate(const size_t nodesCount, const size_t channels) {
+    release();
+    
+    nodesCount_ = nodesCount;
+    channels_ = channels;
+    
+    auto weightsSize = cacheLines(nodesCount_ * channels_ * sizeof(cl_float));
+    auto labelsSize = cacheLines(nodesCount_ * sizeof(cl_int));
+    auto normsSize = cacheLines(nodesCount_ * sizeof(cl_float));
+    
+    // The norms are laid out too, they are a small part of the block
+    memory_ = alignedAlloc(weightsSize + labelsSize + normsSize * 2);
+    
+    weights_ = (cl_float *)memory_;
+    labels_ = (cl_int *)((char *)memory_ + weightsSize);
+}
+
+void FrozenSOM::release() {
+    delete normalizer_;
+    
+    if (memory_) { alignedFree(memory_); }
+    
+    normalizer_ = nullptr;
+    memory_ = nullptr;
+    weights_ = nullptr;
+    labels_ = nullptr;
+    scales_ = nullptr;
+    offsets_ = nullptr;
+    nodesCount_ = 0;
+    channels_ = 0;
+}
+
+#pragma mark - Load
+
+bool FrozenSOM::load(const string &filePath, const bool withNorms) {
+    ifstream is(filePath.c_str(), ios::binary | ios::in);
+    
+    if (!is.is_open()) {
+        return false;
+    }
+    
+    // The grid is only described by the header, the nodes are all that's searched
+    double hexSize;
+    size_t cols, rows, channels, nodesCount;
+    int radius;
+    
+    is.read((char *)&cols, sizeof(size_t));
+    is.read((char *)&rows, sizeof(size_t));
+    is.read((char *)&radius, sizeof(int));
+    is.read((char *)&hexSize, sizeof(double));
+    is.read((char *)&channels, sizeof(size_t));
+    is.read((char *)&nodesCount, sizeof(size_t));
+    
+    if (!is || channels == 0 || nodesCount == 0) {
+        return false;
+    }
+    
+    allocate(nodesCount, channels);
+    
+    normalizer_ = new Normalizer(channels_);
+    normalizer_->load(is);
+    
+    is.read((char *)&metric_, sizeof(DistanceMetric));
+    is.read((char *)weights_, streamsize(nodesCount_ * channels_ * sizeof(cl_float)));
+    
+    // The distances accumulator and the activation states are left to the training
+    is.seekg(streamoff(nodesCount_ * (sizeof(cl_float) + sizeof(cl_int))), ios::cur);
+    is.read((char *)labels_, streamsize(nodesCount_ * sizeof(cl_int)));
+    
+    if (!is || metric_ < EUCLIDEAN || metric_ > MSE) {
+        release();
+        
+        return false;
+    }
+    
+    if (withNorms) {
+        precomputeNorms();
+    }
+    
+    return true;
+}
+
+#pragma mark - Norms
+
+void FrozenSOM::precomputeNorms() {
+    assert(memory_);
+    
+    if (metric_ != EUCLIDEAN && metric_ != SSD && metric_ != MSE && metric_ != COSINE) {
+        return;
+    }
+    
+    auto normsSize = cacheLines(nodesCount_ * sizeof(cl_float));
+    
+    scales_ = (cl_float *)((char *)labels_ + cacheLines(nodesCount_ * sizeof(cl_int)));
+    offsets_ = (cl_float *)((char *)scales_ + normsSize);
+    
+    for (auto i = 0; i < nodesCount_; i++) {
+        double squaredNorm = 0;
+        
+        for (auto j = 0; j < channels_; j++) {
+            squaredNorm += (double)weights_[i * channels_ + j] * weights_[i * channels_ + j];
+        }
+        
+        if (metric_ == COSINE) {
+            // A node at the origin has no direction, it's never the BMU as with the direct distance
+            scales_[i] = squaredNorm > 0 ? -1.0 / sqrt(squaredNorm) : 0;
+            offsets_[i] = squaredNorm > 0 ? 0 : FLT_MAX;
+        } else {
+            scales_[i] = -2;
+            offsets_[i] = squaredNorm;
+        }
+    }
+}
+
+bool FrozenSOM::hasNorms() const {
+    return scales_ != nullptr;
+}
+
+#pragma mark - Predict
+
+int FrozenSOM::predict(const vector<float> &vector) const {
+    size_t bmuIndex = computeBmuIndex(vector);
+    
+    return labels_[bmuIndex];
+}
+
+int FrozenSOM::predict(const uint8_t &pixel) const {
+    size_t bmuIndex = computeBmuIndex(pixel);
+    
+    return labels_[bmuIndex];
+}
+
+void FrozenSOM::predictBatch(const float *data, const size_t count, int *labels) const {
+    vector<size_t> bmuIndices(count);
+    computeBmuIndices(data, count, bmuIndices.data());
+    
+    for (size_t i = 0; i < count; i++) {
+        labels[i] = labels_[bmuIndices[i]];
+    }
+}
+
+void FrozenSOM::predictBatch(const uint8_t *pixelBuffer, const size_t count, int *labels) const {
+    vector<size_t> bmuIndices(count);
+    computeBmuIndices(pixelBuffer, count, bmuIndices.data());
+    
+    for (size_t i = 0; i < count; i++) {
+        labels[i] = labels_[bmuIndices[i]];
+    }
+}
+
+#pragma mark - BMU
+
+size_t FrozenSOM::computeBmuIndex(const vector<float> &vector) const {
+    assert(memory_ && vector.size() == channels_);
+    
+    size_t bmuIndex;
+    computeBmuIndices(vector.data(), 1, &bmuIndex);
+    
+    return bmuIndex;
+}
+
+size_t FrozenSOM::computeBmuIndex(const uint8_t &pixel) const {
+    size_t bmuIndex;
+    computeBmuIndices(&pixel, 1, &bmuIndex);
+    
+    return bmuIndex;
+}
+
+void FrozenSOM::computeBmuIndices(const float *data, const size_t count, size_t *bmuIndices) const {
+    assert(memory_);
+    
+    vector<cl_float> inputs(count * channels_);
+    normalizer_->normalizeVectors(data, count, inputs.data());
+    
+    search(inputs.data(), count, bmuIndices);
+}
+
+void FrozenSOM::computeBmuIndices(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const {
+    assert(memory_);
+    
+    vector<cl_float> inputs(count * channels_);
+    normalizer_->normalizeVectors(pixelBuffer, count, inputs.data());
+    
+    search(inputs.data(), count, bmuIndices);
+}
+
+void FrozenSOM::search(const cl_float *inputs, const size_t count, size_t *bmuIndices) const {
+    auto &kernels = nativeKernels();
+    auto bmu = kernels.bmu[metric_];
+    auto bounded = kernels.boundedBmu[metric_];
+    auto grain = max((size_t)1, MIN_TASK_SIZE / (nodesCount_ * channels_));
+    
+    ThreadPool::shared().parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            const cl_float *vector = &inputs[i * channels_];
+            cl_float distance = FLT_MAX;
+            size_t index;
+            
+            if (scales_) {
+                index = kernels.dotBmu(vector, weights_, channels_, 0, nodesCount_, scales_, offsets_, distance);
+            } else if (bounded) {
+                index = bounded(vector, weights_, channels_, 0, nodesCount_, distance);
+            } else {
+                index = bmu(vector, weights_, channels_, 0, nodesCount_, distance);
+            }
+            
+            bmuIndices[i] = index == SIZE_MAX ? 0 : index;
+        }
+    });
+}
+
+#pragma mark - Getters
+
+size_t FrozenSOM::getNodeDimensionality() const { return channels_; }
+size_t FrozenSOM::getNodesCount() const { return nodesCount_; }
+DistanceMetric FrozenSOM::getMetric() const { return metric_; }
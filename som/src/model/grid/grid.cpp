@@ -51,9 +51,14 @@ cl_float & Grid::getPoints() const { return *points_; }
 
 size_t Grid::getTopologicalDimensionality() const { return topologicalDimensionality_; }
 size_t Grid::getNodesCount() const { return nodesCount_; }
+const vector<Hex> & Grid::getHexes() const { return hexes_; }
 double Grid::getHexSize() const { return hexSize_; }
 double Grid::getTopologicalRadius() const { return topologicalRadius_; };
 
+Point Grid::getTranslation(const Hex &offset) const {
+    return hexToPoint(Layout(orientation_, Point(0, 0), hexSize_), offset);
+}
+
 Size Grid::getSize() const { return size_; }
 Offset Grid::getOffset() const { return offset_; }
 
@@ -36,17 +36,16 @@ HexagonGrid::HexagonGrid(const size_t radius, const double hexSize) : Grid(FLAT_
     Point origin(size_.width/2, size_.height/2);
     Layout layout(orientation_, origin, hexSize_);
     
-    vector<Hex> hexagons;
     for (int q = -radius_; q <= radius_; q++) {
         int r1 = max(-radius_, -q - radius_);
         int r2 = min(radius_, -q + radius_);
         
         for (int r = r1; r <= r2; r++) {
-            hexagons.push_back(Hex(q, r));
+            hexes_.push_back(Hex(q, r));
         }
     }
     
-    nodesCount_ = hexagons.size();
+    nodesCount_ = hexes_.size();
     
     points_ = (cl_float *)malloc(sizeof(cl_float) * nodesCount_ * topologicalDimensionality_);
     corners_ = (cl_float *)malloc(sizeof(cl_float) * nodesCount_ * HEXAGON_CORNERS_COUNT * topologicalDimensionality_);
@@ -54,7 +53,7 @@ HexagonGrid::HexagonGrid(const size_t radius, const double hexSize) : Grid(FLAT_
     size_t pointIndex = 0;
     size_t cornerIndex = 0;
     for (auto i = 0; i < nodesCount_; i++, pointIndex += 2, cornerIndex += HEXAGON_CORNERS_COUNT * topologicalDimensionality_) {
-        Point point = hexToPoint(layout, hexagons[i]);
+        Point point = hexToPoint(layout, hexes_[i]);
         points_[pointIndex]     = point.x;
         points_[pointIndex + 1] = point.y;
         
@@ -0,0 +1,70 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "influence_table.hpp"
+#include "neighbourhood.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace som;
+
+namespace som {
+    // Value of the Gaussian at the radius, which the CUT_GAUSSIAN is lowered by
+    static const cl_float CUT_GAUSSIAN_FLOOR = exp(-0.5f);
+}
+
+InfluenceTable::InfluenceTable(const Neighbourhood &neighbourhood) :
+squaredSpacing_(neighbourhood.getSquaredSpacing()),
+function_(GAUSSIAN),
+neighbourhoodRadius_(-1) {}
+
+void InfluenceTable::update(const NeighbourhoodFunction function, const double neighbourhoodRadius) {
+    if (function == function_ && neighbourhoodRadius == neighbourhoodRadius_) {
+        return;
+    }
+    
+    function_ = function;
+    neighbourhoodRadius_ = neighbourhoodRadius;
+    
+    cl_float squaredRadius = (cl_float)(neighbourhoodRadius * neighbourhoodRadius);
+    
+    table_.resize((size_t)(squaredRadius / squaredSpacing_) + 2);
+    
+    for (auto i = 0; i < table_.size(); i++) {
+        table_[i] = influence(function, i * squaredSpacing_, squaredRadius);
+    }
+}
+
+cl_float InfluenceTable::influence(const NeighbourhoodFunction function, const cl_float squaredDistance, const cl_float squaredRadius) {
+    cl_float x = squaredDistance / squaredRadius;
+    
+    switch (function) {
+        case BUBBLE: return 1;
+        case MEXICAN_HAT: return (1 - 2 * x) * exp(-x);
+        case CUT_GAUSSIAN: return (exp(-x / 2) - CUT_GAUSSIAN_FLOOR) / (1 - CUT_GAUSSIAN_FLOOR);
+        case EPANECHNIKOV: return 1 - x;
+        default: return exp(-squaredDistance / (2 * squaredRadius));
+    }
+}
+
+double InfluenceTable::cutoffRadius(const NeighbourhoodFunction function, const double neighbourhoodRadius, const double threshold) {
+    if (threshold <= 0) {
+        return neighbourhoodRadius;
+    }
+    
+    switch (function) {
+        case GAUSSIAN: return min(neighbourhoodRadius, neighbourhoodRadius * sqrt(-2 * log(threshold)));
+        case CUT_GAUSSIAN: return neighbourhoodRadius * sqrt(-2 * log(CUT_GAUSSIAN_FLOOR + threshold * (1 - CUT_GAUSSIAN_FLOOR)));
+        case EPANECHNIKOV: return neighbourhoodRadius * sqrt(1 - threshold);
+        default: return neighbourhoodRadius;
+    }
+}
@@ -0,0 +1,141 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include "neighbourhood.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace som;
+
+const size_t Neighbourhood::MAX_TABLE_NODES;
+
+Neighbourhood::Neighbourhood(const Grid &grid, const size_t maxTableNodes) :
+nodesCount_(grid.getNodesCount()),
+lookupCols_(0),
+lookupRows_(0) {
+    Point adjacent = grid.getTranslation(Hex(1, 0));
+    squaredSpacing_ = (cl_float)(adjacent.x * adjacent.x + adjacent.y * adjacent.y);
+    
+    if (nodesCount_ <= maxTableNodes) {
+        buildTable(grid);
+    } else {
+        buildStencil(grid);
+    }
+}
+
+void Neighbourhood::buildTable(const Grid &grid) {
+    cl_float *points = &grid.getPoints();
+    
+    table_.resize(nodesCount_ * nodesCount_);
+    
+    for (auto i = 0; i < nodesCount_; i++) {
+        Neighbour *row = &table_[i * nodesCount_];
+        
+        cl_float x = points[i * 2];
+        cl_float y = points[i * 2 + 1];
+        
+        for (auto j = 0; j < nodesCount_; j++) {
+            row[j].index = (cl_uint)j;
+            row[j].squaredDistance = (x - points[j * 2]) * (x - points[j * 2]) + (y - points[j * 2 + 1]) * (y - points[j * 2 + 1]);
+        }
+        
+        sort(row, row + nodesCount_, [](const Neighbour &a, const Neighbour &b) {
+            return a.squaredDistance < b.squaredDistance || (a.squaredDistance == b.squaredDistance && a.index < b.index);
+        });
+    }
+}
+
+void Neighbourhood::buildStencil(const Grid &grid) {
+    auto &hexes = grid.getHexes();
+    
+    int minQ = numeric_limits<int>::max(), maxQ = numeric_limits<int>::min();
+    int minR = numeric_limits<int>::max(), maxR = numeric_limits<int>::min();
+    
+    for (auto &hex : hexes) {
+        minQ = min(minQ, hex.q);
+        maxQ = max(maxQ, hex.q);
+        minR = min(minR, hex.r);
+        maxR = max(maxR, hex.r);
+    }
+    
+    lookupCols_ = maxQ - minQ + 1;
+    lookupRows_ = maxR - minR + 1;
+    
+    lookup_.assign(lookupCols_ * lookupRows_, -1);
+    coordinates_.resize(nodesCount_ * 2);
+    
+    for (auto i = 0; i < nodesCount_; i++) {
+        int col = hexes[i].q - minQ;
+        int row = hexes[i].r - minR;
+        
+        lookup_[col * lookupRows_ + row] = (cl_int)i;
+        coordinates_[i * 2] = col;
+        coordinates_[i * 2 + 1] = row;
+    }
+    
+    // Every offset between two cells of the bounding box
+    int cols = (int)lookupCols_;
+    int rows = (int)lookupRows_;
+    
+    stencil_.reserve((2 * cols - 1) * (2 * rows - 1));
+    
+    for (int dq = 1 - cols; dq < cols; dq++) {
+        for (int dr = 1 - rows; dr < rows; dr++) {
+            Point translation = grid.getTranslation(Hex(dq, dr));
+            cl_float squaredDistance = translation.x * translation.x + translation.y * translation.y;
+            
+            stencil_.push_back({dq, dr, squaredDistance});
+        }
+    }
+    
+    stable_sort(stencil_.begin(), stencil_.end(), [](const StencilOffset &a, const StencilOffset &b) {
+        return a.squaredDistance < b.squaredDistance;
+    });
+}
+
+size_t Neighbourhood::prefixLength(const size_t node, const double radius) const {
+    cl_float squareRadius = radius * radius;
+    
+    if (hasTable()) {
+        auto row = table_.begin() + node * nodesCount_;
+        
+        return upper_bound(row, row + nodesCount_, squareRadius, [](cl_float value, const Neighbour &neighbour) {
+            return value < neighbour.squaredDistance;
+        }) - row;
+    }
+    
+    return upper_bound(stencil_.begin(), stencil_.end(), squareRadius, [](cl_float value, const StencilOffset &offset) {
+        return value < offset.squaredDistance;
+    }) - stencil_.begin();
+}
+
+void Neighbourhood::squaredDistances(const size_t node, cl_float *distances) const {
+    visit(node, numeric_limits<double>::infinity(), [&](cl_uint index, cl_float squaredDistance) {
+        distances[index] = squaredDistance;
+    });
+}
+
+#pragma mark - getters
+
+bool Neighbourhood::hasTable() const { return !table_.empty(); }
+
+const vector<Neighbourhood::Neighbour> & Neighbourhood::getTable() const { return table_; }
+const vector<Neighbourhood::StencilOffset> & Neighbourhood::getStencil() const { return stencil_; }
+const vector<cl_int> & Neighbourhood::getLookup() const { return lookup_; }
+const vector<cl_int> & Neighbourhood::getCoordinates() const { return coordinates_; }
+
+size_t Neighbourhood::getLookupCols() const { return lookupCols_; }
+size_t Neighbourhood::getLookupRows() const { return lookupRows_; }
+size_t Neighbourhood::getNodesCount() const { return nodesCount_; }
+cl_float Neighbourhood::getSquaredSpacing() const { return squaredSpacing_; }
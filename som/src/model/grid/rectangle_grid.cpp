@@ -50,6 +50,7 @@ RectangleGrid::RectangleGrid(const size_t cols, const size_t rows, const double
     for (auto i = 0; i < cols; i++) {
         for (auto j = 0; j < rows; j++, pointIndex += 2, cornerIndex += HEXAGON_CORNERS_COUNT * topologicalDimensionality_) {
             Hex hex = offsetToHex(ODD, OffsetCoord(i, j));
+            hexes_.push_back(hex);
             
             Point point = hexToPoint(layout, hex);
             points_[pointIndex]     = point.x;
@@ -13,7 +13,10 @@
 #include "model.hpp"
 #include <assert.h>
 #include <cstring>
+#include <cstdlib>
+#include "aligned_memory.hpp"
 #include "normalizer.hpp"
+#include "neighbourhood.hpp"
 #include "hexagon_grid.hpp"
 #include "rectangle_grid.hpp"
 
@@ -27,6 +30,9 @@ namespace som {
 Model::Model() :
 grid_(nullptr),
 normalizer_(nullptr),
+neighbourhood_(nullptr),
+metric_(EUCLIDEAN),
+neighbourhoodFunction_(GAUSSIAN),
 input_(nullptr),
 data_(nullptr),
 labels_(nullptr),
@@ -50,14 +56,15 @@ Model::Model(const size_t radius, const size_t channels, const double hexSize) :
 Model::~Model() {
     delete grid_;
     delete normalizer_;
+    delete neighbourhood_;
     
     if (input_) { free(input_); }
     
-    if (data_) { free(data_); }
+    if (data_) { alignedFree(data_); }
     if (labels_) { free(labels_); }
-    if (weights_) { free(weights_); }
-    if (distances_) { free(distances_); }
-    if (distancesAccumulator_) { free(distancesAccumulator_); }
+    if (weights_) { alignedFree(weights_); }
+    if (distances_) { alignedFree(distances_); }
+    if (distancesAccumulator_) { alignedFree(distancesAccumulator_); }
     if (activationStates_) { free(activationStates_); }
 }
 
@@ -102,9 +109,9 @@ bool Model::create() {
     normalizer_ = new Normalizer(channelsCount_);
     
     labels_ = (cl_int *)malloc(sizeof(cl_int) * nodesCount_);
-    weights_ = (cl_float *)malloc(sizeof(cl_float) * nodesCount_ * channelsCount_);
-    distances_ = (cl_float *)malloc(sizeof(cl_float) * nodesCount_);
-    distancesAccumulator_ = (cl_float *)malloc(sizeof(cl_float) * nodesCount_);
+    weights_ = (cl_float *)alignedAlloc(sizeof(cl_float) * nodesCount_ * channelsCount_);
+    distances_ = (cl_float *)alignedAlloc(sizeof(cl_float) * nodesCount_);
+    distancesAccumulator_ = (cl_float *)alignedAlloc(sizeof(cl_float) * nodesCount_);
     activationStates_ = (cl_int *)malloc(sizeof(cl_int) * nodesCount_);
     
     memset(input_, 0, sizeof(cl_float) * channelsCount_);
@@ -222,14 +229,14 @@ void Model::prepare(const vector<vector<cl_float>> &data, const Normalization no
     normalizer_->setNormalizationType(normalizationType);
     
     if (data_) {
-        free(data_);
+        alignedFree(data_);
         data_ = nullptr;
     }
     
     dataCount_ = data.size();
     auto lenght = dataCount_ * channelsCount_;
     
-    data_ = (cl_float *)malloc(sizeof(cl_float) * lenght);
+    data_ = (cl_float *)alignedAlloc(sizeof(cl_float) * lenght);
     data_ = &normalizer_->normalize(data, data_);
     
     uniform_.reset();
@@ -242,13 +249,13 @@ void Model::prepare(const uint8_t *pixelBuffer, const size_t lenght, const Norma
     normalizer_->setNormalizationType(normalizationType);
     
     if (data_) {
-        free(data_);
+        alignedFree(data_);
         data_ = nullptr;
     }
     
     dataCount_ = lenght / channelsCount_;
     
-    data_ = (cl_float *)malloc(sizeof(cl_float) * lenght);
+    data_ = (cl_float *)alignedAlloc(sizeof(cl_float) * lenght);
     data_ = &normalizer_->normalize(pixelBuffer, lenght, data_);
     
     uniform_.reset();
@@ -285,6 +292,14 @@ cl_float & Model::normalizeVector(const uint8_t *vector) {
     return normalizer_->normalize(vector, *input_);
 }
 
+cl_float & Model::normalizeVectors(const cl_float *vectors, const size_t count, cl_float *dst) {
+    return normalizer_->normalizeVectors(vectors, count, dst);
+}
+
+cl_float & Model::normalizeVectors(const uint8_t *vectors, const size_t count, cl_float *dst) {
+    return normalizer_->normalizeVectors(vectors, count, dst);
+}
+
 #pragma mark - setters
 
 void Model::setRandomWeights(const double min, const double max) {
@@ -316,12 +331,18 @@ void Model::setMetric(DistanceMetric metric) {
     metric_ = metric;
 }
 
+void Model::setNeighbourhoodFunction(NeighbourhoodFunction function) {
+    neighbourhoodFunction_ = function;
+}
+
 #pragma mark - getters
 
 cl_float & Model::getRandomDataVector() {
-    size_t randomIndex = uniform_(rng_);
-    
-    return data_[randomIndex * channelsCount_];
+    return data_[getRandomDataIndex() * channelsCount_];
+}
+
+size_t Model::getRandomDataIndex() {
+    return uniform_(rng_);
 }
 
 vector<Cell> Model::getCells() const { return cells_; }
@@ -331,12 +352,22 @@ double Model::getHeight() const { return grid_->getSize().height; }
 
 double Model::getTopologicalRadius() const { return grid_->getTopologicalRadius(); }
 DistanceMetric Model::getMetric() const { return metric_; }
+const Normalizer & Model::getNormalizer() const { return *normalizer_; }
+NeighbourhoodFunction Model::getNeighbourhoodFunction() const { return neighbourhoodFunction_; }
 size_t Model::getDataCount() const { return dataCount_; }
 size_t Model::getNodesCount() const { return nodesCount_; }
 size_t Model::getChannelsCount() const { return channelsCount_; }
 size_t Model::getTopologicalDimensionality() const { return grid_->getTopologicalDimensionality(); }
 
 cl_float & Model::getPoints() const { return grid_->getPoints(); }
+
+const Neighbourhood & Model::getNeighbourhood() {
+    if (!neighbourhood_) {
+        neighbourhood_ = new Neighbourhood(*grid_);
+    }
+    
+    return *neighbourhood_;
+}
 cl_float & Model::getData() const { return *data_; }
 cl_int & Model::getLabels() const { return *labels_; };
 cl_float & Model::getWeights() const { return *weights_; }
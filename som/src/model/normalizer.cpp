@@ -26,6 +26,14 @@ sumComponents_(nullptr) {
     sumComponents_ = (cl_float *)malloc(sizeof(cl_float) * channels_);
 }
 
+Normalizer::Normalizer(const Normalizer &normalizer) :
+Normalizer(normalizer.channels_) {
+    type_ = normalizer.type_;
+    
+    memcpy(derComponents_, normalizer.derComponents_, sizeof(cl_float) * channels_);
+    memcpy(sumComponents_, normalizer.sumComponents_, sizeof(cl_float) * channels_);
+}
+
 Normalizer::~Normalizer() {
     if (derComponents_) {
         free(derComponents_);
@@ -88,3 +96,21 @@ cl_float & Normalizer::normalize(const uint8_t *vector, cl_float &dst) {
     return normalizeVector(vector, dst);
 }
 
+#pragma mark - Normalize input vectors
+
+cl_float & Normalizer::normalizeVectors(const cl_float *src, const size_t count, cl_float *dst) {
+    for (auto i = 0; i < count; i++) {
+        normalizeVector(&src[i * channels_], dst[i * channels_]);
+    }
+    
+    return *dst;
+}
+
+cl_float & Normalizer::normalizeVectors(const uint8_t *src, const size_t count, cl_float *dst) {
+    for (auto i = 0; i < count; i++) {
+        normalizeVector(&src[i * channels_], dst[i * channels_]);
+    }
+    
+    return *dst;
+}
+
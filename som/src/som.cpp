@@ -16,12 +16,38 @@
 #include "model.hpp"
 #include "trainer.hpp"
 #include "computing.hpp"
+#include "program_cache.hpp"
+#include "devices.hpp"
+#include "frozen_som.hpp"
+#include "normalizer.hpp"
+#include "thread_pool.hpp"
+#include <cstring>
 
 using namespace std;
 using namespace som;
 
+namespace som {
+    // Threads of the asynchronous searches, as many as the searches an OpenCL backend runs at once
+    static const size_t ASYNC_SEARCH_THREADS_COUNT = 4;
+    
+    static ThreadPool & asyncSearchThreads() {
+        static ThreadPool threadPool(ASYNC_SEARCH_THREADS_COUNT);
+        
+        return threadPool;
+    }
+    
+    // The future of a search with nothing to search
+    static future<void> readyFuture() {
+        promise<void> ready;
+        ready.set_value();
+        
+        return ready.get_future();
+    }
+}
+
 SOM::SOM(const Device deviceType) :
 deviceType_(deviceType),
+deviceId_(nullptr),
 model_(nullptr),
 trainer_(nullptr),
 computing_(nullptr) {}
@@ -30,15 +56,71 @@ SOM::~SOM() {
     release();
 }
 
+#pragma mark - Program cache
+
+void SOM::setProgramCacheEnabled(const bool enabled) {
+    ProgramCache::setEnabled(enabled);
+}
+
+void SOM::setProgramCacheDirectory(const string &path) {
+    ProgramCache::setDirectory(path);
+}
+
+#pragma mark - Devices
+
+vector<DeviceInfo> SOM::getDevices() {
+    return Devices::list();
+}
+
+bool SOM::selectDevice(const size_t index) {
+    auto devices = Devices::ids();
+    
+    if (index >= devices.size()) {
+        return false;
+    }
+    
+    deviceId_ = devices[index];
+    
+    return true;
+}
+
+bool SOM::selectDevice(const string &name) {
+    auto deviceId = Devices::find(name);
+    
+    if (!deviceId) {
+        return false;
+    }
+    
+    deviceId_ = deviceId;
+    
+    return true;
+}
+
+size_t SOM::selectFastestDevice(const size_t nodesCount, const size_t channels) {
+    assert(nodesCount > 0 && channels > 0);
+    
+    auto index = Devices::fastest(nodesCount, channels);
+    
+    if (index == SIZE_MAX) {
+        deviceType_ = NATIVE;
+        deviceId_ = nullptr;
+    } else {
+        deviceId_ = Devices::ids()[index];
+    }
+    
+    return index;
+}
+
 #pragma mark - Release memory
 
 void SOM::release() {
-    delete trainer_;
-    trainer_ = nullptr;
-    
+    // The steps in flight may still read the trainer buffers
     delete computing_;
     computing_ = nullptr;
     
+    delete trainer_;
+    trainer_ = nullptr;
+    
     delete model_;
     model_ = nullptr;
 }
@@ -58,7 +140,7 @@ bool SOM::load(const string &filePath) {
         return false;
     }
     
-    computing_ = new Computing(*model_, deviceType_);
+    computing_ = Computing::create(*model_, deviceType_, deviceId_);
     trainer_ = new Trainer(*model_, *computing_);
     
     return true;
@@ -71,9 +153,38 @@ bool SOM::save(const string &filePath) {
         return false;
     }
     
+    if (computing_) {
+        computing_->readModel();
+    }
+    
     return model_->save(filePath);
 }
 
+FrozenSOM * SOM::freeze(const bool withNorms) const {
+    if (!model_ || !computing_) {
+        return nullptr;
+    }
+    
+    computing_->readModel();
+    
+    auto nodesCount = model_->getNodesCount();
+    auto channels = model_->getChannelsCount();
+    auto frozen = new FrozenSOM();
+    
+    frozen->allocate(nodesCount, channels);
+    frozen->normalizer_ = new Normalizer(model_->getNormalizer());
+    frozen->metric_ = model_->getMetric();
+    
+    memcpy(frozen->weights_, &model_->getWeights(), nodesCount * channels * sizeof(cl_float));
+    memcpy(frozen->labels_, &model_->getLabels(), nodesCount * sizeof(cl_int));
+    
+    if (withNorms) {
+        frozen->precomputeNorms();
+    }
+    
+    return frozen;
+}
+
 #pragma mark - Create
 
 bool SOM::create(const size_t cols, const size_t rows, const size_t hexSize, const size_t channels) {
@@ -86,7 +197,7 @@ bool SOM::create(const size_t cols, const size_t rows, const size_t hexSize, con
     }
     
     model_ = new Model(cols, rows, channels, hexSize);
-    computing_ = new Computing(*model_, deviceType_);
+    computing_ = Computing::create(*model_, deviceType_, deviceId_);
     trainer_ = new Trainer(*model_, *computing_);
     
     return true;
@@ -102,7 +213,7 @@ bool SOM::create(const size_t radius, const size_t hexSize, const size_t channel
     }
     
     model_ = new Model(radius, channels, hexSize);
-    computing_ = new Computing(*model_, deviceType_);
+    computing_ = Computing::create(*model_, deviceType_, deviceId_);
     trainer_ = new Trainer(*model_, *computing_);
     
     return true;
@@ -114,29 +225,41 @@ void SOM::prepare(const vector<vector<float>> &data, const Normalization normali
     assert(model_ && data.size() > 0 && data[0].size() == model_->getChannelsCount());
     
     model_->prepare(data, normalization, initialWeights);
+    
+    if (computing_) {
+        computing_->writeModel();
+    }
 }
 
 void SOM::prepare(const uint8_t *pixelBuffer, const size_t lenght, const Normalization normalization, const InitialWeights initialWeights) {
     assert(model_ && pixelBuffer && lenght >= model_->getChannelsCount());
 
     model_->prepare(pixelBuffer, lenght, normalization, initialWeights);
+    
+    if (computing_) {
+        computing_->writeModel();
+    }
 }
 
 void SOM::setRandomWeights(const float min, const float max) {
     if (model_) {
         model_->setRandomWeights(min, max);
     }
+    
+    if (computing_) {
+        computing_->writeModel();
+    }
 }
 
 #pragma mark - Training
 
-void SOM::train(const size_t iterationsCount, const double learningRate, const DistanceMetric metric, bool epochMode) {
+void SOM::train(const size_t iterationsCount, const double learningRate, const DistanceMetric metric, bool epochMode, const Training training) {
     assert(model_ && trainer_);
     
     clock_t start = clock();
     
     model_->setMetric(metric);
-    trainer_->learn(iterationsCount, learningRate, epochMode);
+    trainer_->learn(iterationsCount, learningRate, epochMode, training);
     
     cout << "SOM: Train duration: " << setprecision(4) << (clock() - start) / (double)CLOCKS_PER_SEC << endl;
 }
@@ -153,6 +276,50 @@ bool SOM::train(size_t count) {
     return false;
 }
 
+future<void> SOM::trainAsync(const size_t iterationsCount, const double learningRate, const DistanceMetric metric, const Training training) {
+    assert(model_ && trainer_);
+    
+    return async(launch::async, [=] {
+        train(iterationsCount, learningRate, metric, false, training);
+    });
+}
+
+void SOM::setMiniBatchSize(const size_t size) {
+    assert(trainer_);
+    
+    trainer_->setMiniBatchSize(size);
+}
+
+void SOM::setNeighbourhoodThreshold(const double threshold) {
+    assert(trainer_);
+    
+    trainer_->setNeighbourhoodThreshold(threshold);
+}
+
+void SOM::setNeighbourhoodFunction(const NeighbourhoodFunction function) {
+    assert(model_);
+    
+    model_->setNeighbourhoodFunction(function);
+}
+
+void SOM::setFastWinnerSearch(const bool enabled) {
+    assert(trainer_);
+    
+    trainer_->setFastWinnerSearch(enabled);
+}
+
+size_t SOM::getLocalSearchesCount() const {
+    assert(trainer_);
+    
+    return trainer_->getLocalSearchesCount();
+}
+
+size_t SOM::getFallbacksCount() const {
+    assert(trainer_);
+    
+    return trainer_->getFallbacksCount();
+}
+
 #pragma mark - Use
 
 void SOM::setLabel(int label, size_t index) {
@@ -168,54 +335,152 @@ void SOM::setLabels(vector<int> labels, vector<size_t> indices) {
 }
 
 int SOM::predict(const vector<float> &vector) const {
-    assert(computing_ && model_ && (vector.size() == model_->getChannelsCount()));
-    
-    cl_float &input = model_->normalizeVector(vector);
-    size_t bmuIndex = computing_->bmuIndex(input, false);
+    size_t bmuIndex = computeBmuIndex(vector);
     cl_int *labels = &model_->getLabels();
     
     return labels[bmuIndex];
 }
 
 int SOM::predict(const uint8_t &pixel) const {
-    assert(computing_ && model_);
-    
-    cl_float &input = model_->normalizeVector(&pixel);
-    size_t bmuIndex = computing_->bmuIndex(input, false);
+    size_t bmuIndex = computeBmuIndex(pixel);
     cl_int *labels = &model_->getLabels();
     
     return labels[bmuIndex];
 }
 
+void SOM::predictBatch(const float *data, const size_t count, int *labels) const {
+    assert(computing_ && model_);
+    
+    vector<size_t> bmuIndices(count);
+    computeBmuIndices(data, count, bmuIndices.data());
+    
+    cl_int *modelLabels = &model_->getLabels();
+    for (size_t i = 0; i < count; i++) {
+        labels[i] = modelLabels[bmuIndices[i]];
+    }
+}
+
+void SOM::predictBatch(const uint8_t *pixelBuffer, const size_t count, int *labels) const {
+    assert(computing_ && model_);
+    
+    vector<size_t> bmuIndices(count);
+    computeBmuIndices(pixelBuffer, count, bmuIndices.data());
+    
+    cl_int *modelLabels = &model_->getLabels();
+    for (size_t i = 0; i < count; i++) {
+        labels[i] = modelLabels[bmuIndices[i]];
+    }
+}
+
 #pragma mark - BMU
 
+// The queries are normalized into buffers of the call and searched with the reentrant search, so they run concurrently
+
 size_t SOM::computeBmuIndex(const vector<float> &vector) const {
     assert(computing_ && model_ && vector.size() == model_->getChannelsCount());
     
-    cl_float &input = model_->normalizeVector(vector);
+    size_t bmuIndex;
+    computeBmuIndices(vector.data(), 1, &bmuIndex);
     
-    return computing_->bmuIndex(input, false);
+    return bmuIndex;
 }
 
 size_t SOM::computeBmuIndex(const uint8_t &pixel) const {
+    size_t bmuIndex;
+    computeBmuIndices(&pixel, 1, &bmuIndex);
+    
+    return bmuIndex;
+}
+
+void SOM::computeBmuIndices(const float *data, const size_t count, size_t *bmuIndices) const {
     assert(computing_ && model_);
     
-    cl_float &input = model_->normalizeVector(&pixel);
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    cl_float &input = model_->normalizeVectors(data, count, inputs.data());
     
-    return computing_->bmuIndex(input, false);
+    computing_->searchBmuIndices(input, count, bmuIndices, nullptr);
+}
+
+void SOM::computeBmuIndices(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const {
+    assert(computing_ && model_);
+    
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    cl_float &input = model_->normalizeVectors(pixelBuffer, count, inputs.data());
+    
+    computing_->searchBmuIndices(input, count, bmuIndices, nullptr);
+}
+
+void SOM::computeTopK(const float *data, const size_t count, const size_t k, size_t *indices, float *distances) const {
+    assert(computing_ && model_ && k > 0 && k <= model_->getNodesCount());
+    
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    cl_float &input = model_->normalizeVectors(data, count, inputs.data());
+    
+    computing_->topK(input, count, k, indices, distances);
+}
+
+void SOM::computeTopK(const uint8_t *pixelBuffer, const size_t count, const size_t k, size_t *indices, float *distances) const {
+    assert(computing_ && model_ && k > 0 && k <= model_->getNodesCount());
+    
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    cl_float &input = model_->normalizeVectors(pixelBuffer, count, inputs.data());
+    
+    computing_->topK(input, count, k, indices, distances);
+}
+
+future<void> SOM::computeBmuIndicesAsync(const float *data, const size_t count, size_t *bmuIndices) const {
+    assert(computing_ && model_);
+    
+    if (count == 0) {
+        return readyFuture();
+    }
+    
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    model_->normalizeVectors(data, count, inputs.data());
+    
+    return asyncSearchThreads().submit([this, inputs = move(inputs), count, bmuIndices] {
+        computing_->searchBmuIndices(inputs[0], count, bmuIndices, nullptr);
+    });
+}
+
+future<void> SOM::computeBmuIndicesAsync(const uint8_t *pixelBuffer, const size_t count, size_t *bmuIndices) const {
+    assert(computing_ && model_);
+    
+    if (count == 0) {
+        return readyFuture();
+    }
+    
+    vector<cl_float> inputs(count * model_->getChannelsCount());
+    model_->normalizeVectors(pixelBuffer, count, inputs.data());
+    
+    return asyncSearchThreads().submit([this, inputs = move(inputs), count, bmuIndices] {
+        computing_->searchBmuIndices(inputs[0], count, bmuIndices, nullptr);
+    });
 }
 
 #pragma mark - Error
 
-double SOM::computeError() {
+double SOM::computeError(const size_t sampleCount) {
+    assert(computing_);
+    
+    return computing_->error(sampleCount);
+}
+
+void SOM::computeErrors(double &quantizationError, double &topographicError, const size_t sampleCount) {
     assert(computing_);
     
-    return computing_->error();
+    computing_->errors(quantizationError, topographicError, sampleCount);
 }
 
 #pragma mark - ModelView
 
-vector<Cell> SOM::getCells() const { return model_->getCells(); }
+vector<Cell> SOM::getCells() const {
+    if (computing_) {
+        computing_->readModel();
+    }
+    
+    return model_->getCells();
+}
 
 double SOM::getWidth() const { return model_->getWidth(); }
 double SOM::getHeight() const { return model_->getHeight(); }
@@ -0,0 +1,89 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include "som_pack.hpp"
+#include <assert.h>
+#include "model.hpp"
+#include "computing.hpp"
+#include "devices.hpp"
+#include "model_pack.hpp"
+
+using namespace std;
+using namespace som;
+
+SOMPack::SOMPack(const vector<const SOM *> &soms) :
+soms_(soms),
+pack_(nullptr) {
+    assert(!soms_.empty());
+    
+    vector<const Model *> models;
+    
+    for (auto &som : soms_) {
+        assert(som->model_ && som->computing_);
+        
+        som->computing_->readModel();
+        models.push_back(som->model_);
+    }
+    
+    // The device the first SOM was created on, the native search without one
+    auto first = soms_[0];
+    auto deviceId = first->deviceId_;
+    
+    if (!deviceId && first->deviceType_ != NATIVE) {
+        deviceId = Devices::find(first->deviceType_);
+    }
+    
+    pack_ = new ModelPack(models, deviceId);
+}
+
+SOMPack::~SOMPack() {
+    delete pack_;
+}
+
+void SOMPack::update() {
+    for (auto &som : soms_) {
+        som->computing_->readModel();
+    }
+    
+    pack_->update();
+}
+
+void SOMPack::computeBmuIndices(const float *data, const size_t *somIndices, const size_t count, size_t *bmuIndices) const {
+    if (count == 0) {
+        return;
+    }
+    
+    auto channels = soms_[0]->model_->getChannelsCount();
+    
+    vector<cl_float> inputs(count * channels);
+    vector<cl_uint> models(count);
+    
+    // Each vector is normalized like the data of its SOM
+    for (auto i = 0; i < count; i++) {
+        assert(somIndices[i] < soms_.size());
+        
+        soms_[somIndices[i]]->model_->normalizeVectors(&data[i * channels], 1, &inputs[i * channels]);
+        models[i] = (cl_uint)somIndices[i];
+    }
+    
+    pack_->bmuIndices(inputs[0], models.data(), count, bmuIndices);
+}
+
+void SOMPack::predictBatch(const float *data, const size_t *somIndices, const size_t count, int *labels) const {
+    vector<size_t> bmuIndices(count);
+    computeBmuIndices(data, somIndices, count, bmuIndices.data());
+    
+    for (auto i = 0; i < count; i++) {
+        labels[i] = (&soms_[somIndices[i]]->model_->getLabels())[bmuIndices[i]];
+    }
+}
@@ -13,18 +13,41 @@
 #include "model.hpp"
 #include "trainer.hpp"
 #include "computing.hpp"
+#include "influence_table.hpp"
+#include "neighbourhood.hpp"
+#include <cstring>
+#include <float.h>
+#include <limits.h>
 
 using namespace std;
 using namespace som;
 
+namespace som {
+    static const size_t DEFAULT_MINI_BATCH_SIZE = 64;
+    
+    // Rings searched around the last BMU of a vector, their radii are whole multiples of the node spacing
+    static const size_t FAST_WINNER_RINGS = 3;
+    
+    // Growth of the BMU distance of a vector since its last step beyond which a local minimum isn't trusted
+    static const double FAST_WINNER_TOLERANCE = 0.25;
+}
+
 Trainer::Trainer(Model &model, Computing &computing) :
 model_(model),
 computing_(computing),
+training_(ONLINE),
+miniBatchSize_(DEFAULT_MINI_BATCH_SIZE),
+neighbourhoodThreshold_(0),
+fastWinnerSearch_(false),
+localSearchesCount_(0),
+fallbacksCount_(0),
+miniBatchIndex_(0),
 remainingIterationsCount_(0) {}
 
 #pragma mark - Train
 
-void Trainer::learn(const size_t iterationsCount, const double learningRate, bool epochMode) {
+void Trainer::learn(const size_t iterationsCount, const double learningRate, bool epochMode, const Training training) {
+    training_ = training;
     learningRate_ = learningRate;
     startLearningRate_ = learningRate;
     topologicalRadius_ = model_.getTopologicalRadius();
@@ -32,54 +55,216 @@ void Trainer::learn(const size_t iterationsCount, const double learningRate, boo
     remainingIterationsCount_ = iterationsCount;
     iterationCount_ = 0;
     
+    lastBmuIndices_.clear();
+    lastBmuDistances_.clear();
+    localSearchesCount_ = 0;
+    fallbacksCount_ = 0;
+    
     if (!epochMode) {
         while (!epoch()) {}
     }
 }
 
+void Trainer::setMiniBatchSize(const size_t size) {
+    computing_.finish();
+    
+    miniBatchSize_ = max((size_t)1, size);
+}
+
+void Trainer::setNeighbourhoodThreshold(const double threshold) {
+    neighbourhoodThreshold_ = min(max(threshold, 0.0), 1.0);
+}
+
+void Trainer::setFastWinnerSearch(const bool enabled) {
+    fastWinnerSearch_ = enabled;
+}
+
+size_t Trainer::getLocalSearchesCount() const {
+    return localSearchesCount_;
+}
+
+size_t Trainer::getFallbacksCount() const {
+    return fallbacksCount_;
+}
+
 bool Trainer::epoch() {
     if (remainingIterationsCount_ > 0) {
-        cl_int *activationStates = &model_.getActivationStates();
-        auto nodesCount = model_.getNodesCount();
+        switch (training_) {
+            case ONLINE: onlineStep(); break;
+            case BATCH: batchStep(); break;
+            case MINI_BATCH: miniBatchStep(); break;
+        }
+    } else {
+        return true;
+    }
+    
+    // The last steps may still be running, their buffers are released with the training
+    if (remainingIterationsCount_ == 0) {
+        computing_.finish();
+    }
+    
+    return false;
+}
+
+#pragma mark - Fast winner search
+
+bool Trainer::localBmuIndex(const size_t dataIndex, const cl_float &vector, size_t &bmuIndex) {
+    auto seed = lastBmuIndices_[dataIndex];
+    
+    if (seed == UINT_MAX) {
+        return false;
+    }
+    
+    auto &neighbourhood = model_.getNeighbourhood();
+    auto squaredSpacing = neighbourhood.getSquaredSpacing();
+    
+    ringNodes_.clear();
+    ringNumbers_.clear();
+    
+    // The squared radius of the outer ring is padded against the rounding of the squared distances
+    neighbourhood.visit(seed, FAST_WINNER_RINGS * sqrt(squaredSpacing * 1.001), [&](cl_uint index, cl_float squaredDistance) {
+        ringNodes_.push_back(index);
+        ringNumbers_.push_back((size_t)ceil(sqrt(squaredDistance / squaredSpacing) - 0.001));
+    });
+    
+    ringDistances_.resize(ringNodes_.size());
+    
+    size_t bestIndex = SIZE_MAX;
+    cl_float bestDistance = FLT_MAX;
+    size_t begin = 0;
+    
+    // The seed is the ring 0, the search stops at the first ring that is farther than the nodes inside it
+    for (size_t ring = 0; ring <= FAST_WINNER_RINGS && begin < ringNodes_.size(); ring++) {
+        auto end = begin;
+        while (end < ringNodes_.size() && ringNumbers_[end] == ring) {
+            end++;
+        }
         
-        cl_float &vector = model_.getRandomDataVector();
-        size_t bmuIndex = computing_.bmuIndex(vector, true);
+        if (!computing_.nodeDistances(vector, &ringNodes_[begin], end - begin, &ringDistances_[begin])) {
+            return false;
+        }
         
-        activationStates[bmuIndex]++;
+        if (ring == 0) {
+            localSearchesCount_++;
+        }
         
-        neighbourhoodRadius_ = topologicalRadius_ * exp(-(double)iterationCount_ / timeConstant_);
-        double squareNeighborhood  = neighbourhoodRadius_ * neighbourhoodRadius_;
+        size_t ringIndex = SIZE_MAX;
+        cl_float ringDistance = FLT_MAX;
         
-        cl_float *topologicalDistances = &computing_.pointDistances(bmuIndex);
-
-        for (auto i = 0; i < nodesCount; i++) {
-            double distance = topologicalDistances[i];
-
-            if (distance <= squareNeighborhood ) {
-                influence_ = exp(-(distance) / (2 * squareNeighborhood));
-
-                adjustWeights(&vector, i);
+        for (auto i = begin; i < end; i++) {
+            if (ringDistances_[i] < ringDistance || (ringDistances_[i] == ringDistance && ringNodes_[i] < ringIndex)) {
+                ringDistance = ringDistances_[i];
+                ringIndex = ringNodes_[i];
             }
         }
         
-        learningRate_ = startLearningRate_ * exp(-(double)iterationCount_ / remainingIterationsCount_);
+        if (ring > 0 && ringDistance > bestDistance) {
+            if (bestDistance > lastBmuDistances_[dataIndex] * (1.0 + FAST_WINNER_TOLERANCE)) {
+                break;
+            }
+            
+            bmuIndex = bestIndex;
+            lastBmuDistances_[dataIndex] = bestDistance;
+            
+            return true;
+        }
+        
+        if (ringDistance < bestDistance || (ringDistance == bestDistance && ringIndex < bestIndex)) {
+            bestDistance = ringDistance;
+            bestIndex = ringIndex;
+        }
+        
+        begin = end;
+    }
+    
+    // The rings covered the whole map
+    if (begin == ringNodes_.size() && begin == model_.getNodesCount()) {
+        bmuIndex = bestIndex;
+        lastBmuDistances_[dataIndex] = bestDistance;
         
-        iterationCount_++;
-        remainingIterationsCount_--;
-    } else {
         return true;
     }
     
+    fallbacksCount_++;
+    
     return false;
 }
 
-void Trainer::adjustWeights(const cl_float *inputVector, const size_t nodeIndex) {
-    cl_float *weights = &model_.getWeights();
-    auto vectorSize = model_.getChannelsCount();
+#pragma mark - Steps
+
+void Trainer::onlineStep() {
+    cl_int *activationStates = &model_.getActivationStates();
+    
+    auto dataIndex = model_.getRandomDataIndex();
+    cl_float &vector = (&model_.getData())[dataIndex * model_.getChannelsCount()];
     
-    auto index0 = nodeIndex * vectorSize;
-    for (auto i = 0; i < vectorSize; i++) {
-        auto index_ = index0 + i;
-        weights[index_] += learningRate_ * influence_ * (inputVector[i] - weights[index_]);
+    size_t bmuIndex;
+    
+    if (!fastWinnerSearch_) {
+        bmuIndex = computing_.bmuIndex(vector, true);
+    } else {
+        if (lastBmuIndices_.size() != model_.getDataCount()) {
+            lastBmuIndices_.assign(model_.getDataCount(), UINT_MAX);
+            lastBmuDistances_.assign(model_.getDataCount(), FLT_MAX);
+        }
+        
+        if (!localBmuIndex(dataIndex, vector, bmuIndex)) {
+            bmuIndex = computing_.bmuIndex(vector, true, lastBmuDistances_[dataIndex]);
+        }
+        
+        lastBmuIndices_[dataIndex] = (cl_uint)bmuIndex;
     }
+    
+    activationStates[bmuIndex]++;
+    
+    neighbourhoodRadius_ = topologicalRadius_ * exp(-(double)iterationCount_ / timeConstant_);
+    
+    double cutoffRadius = InfluenceTable::cutoffRadius(model_.getNeighbourhoodFunction(), neighbourhoodRadius_, neighbourhoodThreshold_);
+    
+    computing_.adjustWeights(bmuIndex, neighbourhoodRadius_, learningRate_, cutoffRadius);
+    
+    learningRate_ = startLearningRate_ * exp(-(double)iterationCount_ / remainingIterationsCount_);
+    
+    iterationCount_++;
+    remainingIterationsCount_--;
+}
+
+void Trainer::batchStep() {
+    neighbourhoodRadius_ = topologicalRadius_ * exp(-(double)iterationCount_ / timeConstant_);
+    
+    computing_.adjustWeightsBatch(neighbourhoodRadius_);
+    
+    iterationCount_++;
+    remainingIterationsCount_--;
+}
+
+void Trainer::miniBatchStep() {
+    auto channels = model_.getChannelsCount();
+    auto count = min(miniBatchSize_, remainingIterationsCount_);
+    
+    auto &miniBatch = miniBatches_[miniBatchIndex_];
+    auto &schedule = schedules_[miniBatchIndex_];
+    
+    miniBatchIndex_ = (miniBatchIndex_ + 1) % 2;
+    
+    miniBatch.resize(count * channels);
+    schedule.resize(count * 2);
+    
+    // The schedules advance per processed vector, as in the online mode
+    for (auto i = 0; i < count; i++) {
+        cl_float &vector = model_.getRandomDataVector();
+        memcpy(&miniBatch[i * channels], &vector, sizeof(cl_float) * channels);
+        
+        neighbourhoodRadius_ = topologicalRadius_ * exp(-(double)iterationCount_ / timeConstant_);
+        
+        schedule[i * 2] = neighbourhoodRadius_;
+        schedule[i * 2 + 1] = learningRate_;
+        
+        learningRate_ = startLearningRate_ * exp(-(double)iterationCount_ / remainingIterationsCount_);
+        
+        iterationCount_++;
+        remainingIterationsCount_--;
+    }
+    
+    computing_.adjustWeightsMiniBatch(miniBatch[0], count, schedule[0]);
 }
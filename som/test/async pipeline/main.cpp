@@ -0,0 +1,195 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstring>
+#include "som.hpp"
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+void assertModelsEqual(Model &expected, Model &model) {
+    const auto nodesCount = model.getNodesCount();
+    
+    for (auto i = 0; i < nodesCount * model.getChannelsCount(); i++) {
+        assert(cmpf((&model.getWeights())[i], (&expected.getWeights())[i]));
+    }
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        assert((&model.getActivationStates())[i] == (&expected.getActivationStates())[i]);
+    }
+}
+
+vector<vector<cl_float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<cl_float>> data(count, vector<cl_float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// More vectors than a staging tile holds, so the search runs through both slots several times
+void testStagedSearch() {
+    const auto channels = 64;
+    const auto dataCount = 40000;
+    
+    auto data = randomData(dataCount, channels);
+    
+    Model expectedModel(6, 5, channels, 5);
+    Model model(6, 5, channels, 5);
+    
+    expectedModel.prepare(data, NO_NORM, RANDOM_0_1);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * model.getNodesCount() * channels);
+    
+    NativeComputing expectedComputing(expectedModel);
+    CLComputing computing(model, ALL_DEVICES);
+    
+    vector<size_t> expectedIndices(dataCount);
+    vector<size_t> indices(dataCount);
+    
+    expectedComputing.bmuIndices(expectedModel.getData(), dataCount, expectedIndices.data());
+    computing.bmuIndices(model.getData(), dataCount, indices.data());
+    
+    cl_float *data0 = &model.getData();
+    cl_float *weights = &model.getWeights();
+    
+    for (auto i = 0; i < dataCount; i++) {
+        if (indices[i] == expectedIndices[i]) {
+            continue;
+        }
+        
+        // Near ties may resolve differently, the distances still have to match
+        cl_float distance = 0, expectedDistance = 0;
+        
+        for (auto j = 0; j < channels; j++) {
+            auto value = data0[i * channels + j];
+            distance += pow(value - weights[indices[i] * channels + j], 2);
+            expectedDistance += pow(value - weights[expectedIndices[i] * channels + j], 2);
+        }
+        
+        assert(cmpf(distance, expectedDistance));
+    }
+}
+
+// Consecutive mini-batch steps overlap, the results are applied once the next step is in flight
+void testMiniBatchPipeline() {
+    const auto cols = 9;
+    const auto rows = 7;
+    const auto channels = 5;
+    const auto batchSize = 8;
+    const auto stepsCount = 12;
+    
+    auto data = randomData(200, channels);
+    
+    Model expectedModel(cols, rows, channels, 5);
+    Model model(cols, rows, channels, 5);
+    
+    expectedModel.prepare(data, NO_NORM, RANDOM_0_1);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * model.getNodesCount() * channels);
+    
+    NativeComputing expectedComputing(expectedModel);
+    CLComputing computing(model, ALL_DEVICES);
+    
+    // Each step owns its buffers, they aren't reused before the next step returns
+    vector<vector<cl_float>> schedules(stepsCount, vector<cl_float>(batchSize * 2));
+    
+    for (auto step = 0; step < stepsCount; step++) {
+        auto &schedule = schedules[step];
+        
+        for (auto i = 0; i < batchSize; i++) {
+            schedule[i * 2] = 4.0f - step * 0.2f;
+            schedule[i * 2 + 1] = 0.1f;
+        }
+        
+        auto offset = step * batchSize * channels;
+        
+        expectedComputing.adjustWeightsMiniBatch((&expectedModel.getData())[offset], batchSize, schedule[0]);
+        computing.adjustWeightsMiniBatch((&model.getData())[offset], batchSize, schedule[0]);
+    }
+    
+    computing.readModel();
+    expectedComputing.readModel();
+    assertModelsEqual(expectedModel, model);
+}
+
+// The asynchronous API against the blocking one
+void testAsyncApi() {
+    const auto channels = 3;
+    const auto dataCount = 500;
+    
+    auto data = randomData(dataCount, channels);
+    
+    vector<float> vectors;
+    for (auto &vector : data) {
+        vectors.insert(vectors.end(), vector.begin(), vector.end());
+    }
+    
+    SOM som(ALL_DEVICES);
+    som.create(8, 8, 5, channels);
+    som.prepare(data);
+    
+    auto training = som.trainAsync(2000, 0.2, EUCLIDEAN, MINI_BATCH);
+    training.wait();
+    
+    vector<size_t> expectedIndices(dataCount);
+    vector<size_t> indices(dataCount);
+    
+    som.computeBmuIndices(vectors.data(), dataCount, expectedIndices.data());
+    
+    auto search = som.computeBmuIndicesAsync(vectors.data(), dataCount, indices.data());
+    search.get();
+    
+    assert(indices == expectedIndices);
+    
+    // An empty batch is ready at once
+    auto empty = som.computeBmuIndicesAsync(vectors.data(), 0, indices.data());
+    assert(empty.wait_for(chrono::seconds(0)) == future_status::ready);
+    empty.get();
+    
+    auto activationsCount = 0;
+    for (auto &cell : som.getCells()) {
+        activationsCount += cell.state[0];
+    }
+    
+    assert(activationsCount == 2000);
+    
+    // The nodes only move towards the means of the batches, within the range of the data
+    for (auto &cell : som.getCells()) {
+        for (auto j = 0; j < channels; j++) {
+            assert(cell.weights[j] >= 0.0f && cell.weights[j] <= 1.0f);
+        }
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testStagedSearch();
+    testMiniBatchPipeline();
+    testAsyncApi();
+    
+    return 0;
+}
@@ -0,0 +1,142 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <assert.h>
+#include <float.h>
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon);
+}
+
+// Host reference of a batch SOM step with the Euclidean metric
+vector<cl_float> batchStep(const Model &model, const vector<vector<cl_float>> &data, const double radius, vector<size_t> &counts) {
+    const auto channels = model.getChannelsCount();
+    const auto nodesCount = model.getNodesCount();
+    
+    cl_float *weights = &model.getWeights();
+    cl_float *points = &model.getPoints();
+    
+    vector<cl_float> sums(nodesCount * channels, 0);
+    counts.assign(nodesCount, 0);
+    
+    for (auto &vector : data) {
+        size_t bmu = 0;
+        auto lowestDistance = FLT_MAX;
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            auto distance = 0.0f;
+            
+            for (auto j = 0; j < channels; j++) {
+                distance += (vector[j] - weights[i * channels + j]) * (vector[j] - weights[i * channels + j]);
+            }
+            
+            // Ranked like the device, sqrt may round neighbouring distances to a tie
+            distance = sqrt(distance);
+            
+            if (distance < lowestDistance) {
+                lowestDistance = distance;
+                bmu = i;
+            }
+        }
+        
+        counts[bmu]++;
+        
+        for (auto j = 0; j < channels; j++) {
+            sums[bmu * channels + j] += vector[j];
+        }
+    }
+    
+    vector<cl_float> result(weights, weights + nodesCount * channels);
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        double influenceSum = 0;
+        vector<double> weightedSum(channels, 0);
+        
+        for (auto k = 0; k < nodesCount; k++) {
+            auto dx = points[k * 2] - points[i * 2];
+            auto dy = points[k * 2 + 1] - points[i * 2 + 1];
+            auto distance = dx * dx + dy * dy;
+            
+            if (counts[k] > 0 && distance <= radius * radius) {
+                auto influence = exp(-distance / (2 * radius * radius));
+                
+                influenceSum += influence * counts[k];
+                
+                for (auto j = 0; j < channels; j++) {
+                    weightedSum[j] += influence * sums[k * channels + j];
+                }
+            }
+        }
+        
+        if (influenceSum > 0) {
+            for (auto j = 0; j < channels; j++) {
+                result[i * channels + j] = weightedSum[j] / influenceSum;
+            }
+        }
+    }
+    
+    return result;
+}
+
+int main(int argc, const char * argv[]) {
+    // Create model
+    const auto cols = 8;
+    const auto rows = 6;
+    const auto channels = 3;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 500;
+    
+    srand(1);
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model model(cols, rows, channels, hexSize);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    model.setMetric(EUCLIDEAN);
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    // Shrinking neighbourhood, down to the plain cluster means
+    for (auto radius : {20.0, 10.0, 1.0}) {
+        vector<size_t> counts;
+        auto expectedWeights = batchStep(model, data, radius, counts);
+        
+        vector<cl_int> states(&model.getActivationStates(), &model.getActivationStates() + nodesCount);
+        
+        computing.adjustWeightsBatch(radius);
+        computing.readModel();
+        
+        cl_float *weights = &model.getWeights();
+        cl_int *activationStates = &model.getActivationStates();
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            assert(activationStates[i] == states[i] + counts[i]);
+            
+            for (auto j = 0; j < channels; j++) {
+                assert(cmpf(weights[i * channels + j], expectedWeights[i * channels + j]));
+            }
+        }
+    }
+    
+    return 0;
+}
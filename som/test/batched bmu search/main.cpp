@@ -0,0 +1,58 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <assert.h>
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+int main(int argc, const char * argv[]) {
+    // Create model
+    const auto cols = 20;
+    const auto rows = 15;
+    const auto channels = 3;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto vectorsCount = 50;
+    
+    Model model(cols, rows, channels, hexSize);
+    
+    cl_float *weights = &model.getWeights();
+    
+    srand(1);
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        weights[i] = (cl_float)rand() / RAND_MAX;
+    }
+    
+    vector<cl_float> vectors(vectorsCount * channels);
+    for (auto &value : vectors) {
+        value = (cl_float)rand() / RAND_MAX;
+    }
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    // Batched search matches the single vector search for every metric
+    for (auto metric : {SAD, SSD, MAE, MSE, EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, CANBERRA, COSINE}) {
+        model.setMetric(metric);
+        
+        vector<size_t> bmuIndices(vectorsCount);
+        computing.bmuIndices(vectors[0], vectorsCount, bmuIndices.data());
+        
+        for (auto i = 0; i < vectorsCount; i++) {
+            assert(bmuIndices[i] == computing.bmuIndex(vectors[i * channels], false));
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,98 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <assert.h>
+#include <float.h>
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+size_t hostBmuIndex(const cl_float *distances, const size_t nodesCount) {
+    size_t index = 0;
+    auto lowestDistance = FLT_MAX;
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        if (distances[i] < lowestDistance) {
+            lowestDistance = distances[i];
+            index = i;
+        }
+    }
+    
+    return index;
+}
+
+int main(int argc, const char * argv[]) {
+    // Create model with more nodes than a single work-group reduces
+    const auto cols = 40;
+    const auto rows = 30;
+    const auto channels = 3;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto queriesCount = 20;
+    
+    Model model(cols, rows, channels, hexSize);
+    
+    cl_float *weights = &model.getWeights();
+    
+    srand(1);
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        weights[i] = (cl_float)rand() / RAND_MAX;
+    }
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    vector<cl_float> expectedAccumulator(nodesCount, 0);
+    
+    for (auto metric : {SSD, EUCLIDEAN, CHEBYSHEV, COSINE}) {
+        model.setMetric(metric);
+        
+        for (auto q = 0; q < queriesCount; q++) {
+            vector<cl_float> inputVector {(cl_float)rand() / RAND_MAX, (cl_float)rand() / RAND_MAX, (cl_float)rand() / RAND_MAX};
+            
+            cl_float distance;
+            auto index = computing.bmuIndex(*inputVector.data(), true, distance);
+            
+            cl_float *distances = &computing.weightDistances();
+            
+            assert(index == hostBmuIndex(distances, nodesCount));
+            assert(distance == distances[index]);
+            
+            for (auto i = 0; i < nodesCount; i++) {
+                if (distances[i] > 0.0) {
+                    expectedAccumulator[i] += distances[i];
+                }
+            }
+        }
+    }
+    
+    // Distances accumulated on the device
+    computing.readModel();
+    
+    cl_float *distancesAccumulator = &model.getDistancesAccumulator();
+    for (auto i = 0; i < nodesCount; i++) {
+        assert(fabs(distancesAccumulator[i] - expectedAccumulator[i]) < 0.0005f);
+    }
+    
+    // Ties are resolved to the lowest node index
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        weights[i] = 0.5;
+    }
+    
+    computing.writeModel();
+    
+    vector<cl_float> inputVector {0.1, 0.2, 0.3};
+    assert(computing.bmuIndex(*inputVector.data(), false) == 0);
+    
+    return 0;
+}
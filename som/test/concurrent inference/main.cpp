@@ -0,0 +1,185 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <vector>
+#include <thread>
+#include "som.hpp"
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+static const size_t THREADS_COUNT = 8;
+
+vector<vector<float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<float>> data(count, vector<float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// Every thread searches all the vectors, one at a time and batched, and finds the BMUs of a single thread
+void searchConcurrently(const SOM &som, const vector<vector<float>> &data, const vector<size_t> &expected) {
+    auto channels = som.getNodeDimensionality();
+    
+    vector<float> batch;
+    
+    for (auto &vector : data) {
+        batch.insert(batch.end(), vector.begin(), vector.end());
+    }
+    
+    vector<thread> threads;
+    vector<size_t> mismatches(THREADS_COUNT, 0);
+    
+    for (auto t = 0; t < THREADS_COUNT; t++) {
+        threads.emplace_back([&, t] {
+            // The threads start at different vectors, so they search different ones at the same time
+            for (auto i = 0; i < data.size(); i++) {
+                auto index = (i + t * 7) % data.size();
+                
+                if (som.computeBmuIndex(data[index]) != expected[index]) {
+                    mismatches[t]++;
+                }
+            }
+            
+            vector<size_t> bmuIndices(data.size());
+            som.computeBmuIndices(batch.data(), data.size(), bmuIndices.data());
+            
+            for (auto i = 0; i < data.size(); i++) {
+                mismatches[t] += bmuIndices[i] != expected[i];
+            }
+            
+            vector<int> labels(data.size());
+            som.predictBatch(&batch[0], batch.size() / channels, labels.data());
+            
+            for (auto i = 0; i < data.size(); i++) {
+                mismatches[t] += labels[i] != som.predict(data[i]);
+            }
+        });
+    }
+    
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    
+    for (auto count : mismatches) {
+        assert(count == 0);
+    }
+}
+
+vector<size_t> bmuIndices(const SOM &som, const vector<vector<float>> &data) {
+    vector<size_t> indices;
+    
+    for (auto &vector : data) {
+        indices.push_back(som.computeBmuIndex(vector));
+    }
+    
+    return indices;
+}
+
+void test(const Device device, const DistanceMetric metric) {
+    const auto channels = 6;
+    
+    auto data = randomData(60, channels);
+    auto queries = randomData(200, channels);
+    
+    SOM som(device);
+    
+    assert(som.create(12, 10, 5, channels));
+    
+    som.prepare(data, MINMAX_BY_COLUMNS, RANDOM_FROM_DATA);
+    som.train(2, 0.3, metric);
+    
+    vector<int> labels;
+    vector<size_t> nodes;
+    
+    for (auto i = 0; i < 12 * 10; i += 3) {
+        labels.push_back(i % 5);
+        nodes.push_back(i);
+    }
+    
+    som.setLabels(labels, nodes);
+    
+    searchConcurrently(som, queries, bmuIndices(som, queries));
+    
+    // The searches after more training see the new weights
+    som.train(1, 0.5, metric);
+    
+    searchConcurrently(som, queries, bmuIndices(som, queries));
+}
+
+// Twice as many threads as workers search at once, round after round, the workers are handed from thread to thread
+// instead of piling up per thread
+void testWorkers() {
+    const auto channels = 6;
+    const auto count = 50;
+    
+    if (!CLComputing::isAvailable(ALL_DEVICES)) {
+        return;
+    }
+    
+    Model model(12, 10, channels, 5);
+    model.prepare(randomData(count, channels), NO_NORM, RANDOM_0_1);
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    cl_float *data = &model.getData();
+    vector<size_t> expected(count);
+    
+    computing.bmuIndices(data[0], count, expected.data());
+    
+    for (auto round = 0; round < 3; round++) {
+        vector<thread> threads;
+        vector<size_t> mismatches(CLComputing::MAX_WORKERS_COUNT * 2, 0);
+        
+        for (auto t = 0; t < mismatches.size(); t++) {
+            threads.emplace_back([&, t] {
+                vector<size_t> bmuIndices(count);
+                computing.searchBmuIndices(data[0], count, bmuIndices.data(), nullptr);
+                
+                mismatches[t] = bmuIndices != expected;
+            });
+        }
+        
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        
+        for (auto count : mismatches) {
+            assert(count == 0);
+        }
+        
+        assert(computing.getWorkersCount() > 0 && computing.getWorkersCount() <= CLComputing::MAX_WORKERS_COUNT);
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testWorkers();
+    
+    for (auto device : {ALL_DEVICES, NATIVE, MULTI_DEVICE}) {
+        for (auto metric : {EUCLIDEAN, COSINE}) {
+            test(device, metric);
+        }
+    }
+    
+    return 0;
+}
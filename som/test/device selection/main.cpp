@@ -0,0 +1,137 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+#include "som.hpp"
+#include "devices.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+vector<vector<float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<float>> data(count, vector<float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// Trains a small map and checks that a data vector finds a node
+void trainAndSearch(SOM &som) {
+    const auto channels = 3;
+    auto data = randomData(30, channels);
+    
+    assert(som.create(8, 6, 5, channels));
+    
+    som.prepare(data, NO_NORM, RANDOM_FROM_DATA);
+    som.train(2, 0.3);
+    
+    assert(som.computeBmuIndex(data[0]) < 8 * 6);
+}
+
+// The listed devices describe themselves and keep the order of the ids
+void testList() {
+    auto devices = SOM::getDevices();
+    auto ids = Devices::ids();
+    
+    assert(devices.size() == ids.size());
+    
+    for (auto i = 0; i < devices.size(); i++) {
+        auto &device = devices[i];
+        
+        assert(device.index == i);
+        assert(!device.platform.empty());
+        assert(!device.name.empty());
+        assert(device.computeUnits > 0);
+        assert(device.globalMemorySize > 0);
+        assert(device.maxAllocationSize > 0 && device.maxAllocationSize <= device.globalMemorySize);
+        assert(device.preferredVectorWidth > 0);
+        
+        cl_bool unifiedMemory = CL_FALSE;
+        clGetDeviceInfo(ids[i], CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unifiedMemory, nullptr);
+        
+        assert(device.unifiedMemory == (unifiedMemory == CL_TRUE));
+        
+        // The first listed device of a type is the one found for the type
+        if (device.type != ALL_DEVICES) {
+            auto first = find_if(devices.begin(), devices.end(), [&](const DeviceInfo &other) { return other.type == device.type; });
+            
+            assert(Devices::find(device.type) == ids[first->index]);
+        }
+    }
+}
+
+// The devices of every platform are searched for the type
+void testFind() {
+    auto devices = SOM::getDevices();
+    
+    for (auto type : {CPU, GPU}) {
+        auto listed = find_if(devices.begin(), devices.end(), [&](const DeviceInfo &device) { return device.type == type; });
+        
+        assert((Devices::find(type) != nullptr) == (listed != devices.end()));
+        assert(CLComputing::isAvailable(type) == (listed != devices.end()));
+        
+        // Without a device of the type the native backend takes over instead of failing
+        SOM som(type);
+        trainAndSearch(som);
+    }
+}
+
+void testSelection() {
+    auto devices = SOM::getDevices();
+    
+    for (auto &device : devices) {
+        SOM byIndex(NATIVE);
+        assert(byIndex.selectDevice(device.index));
+        trainAndSearch(byIndex);
+        
+        SOM byName(NATIVE);
+        assert(byName.selectDevice(device.name));
+        trainAndSearch(byName);
+    }
+    
+    SOM som(ALL_DEVICES);
+    
+    assert(!som.selectDevice(devices.size()));
+    assert(!som.selectDevice("No such device"));
+    
+    trainAndSearch(som);
+}
+
+void testFastest() {
+    SOM som(ALL_DEVICES);
+    
+    auto index = som.selectFastestDevice(200, 4);
+    
+    assert(index == SIZE_MAX || index < SOM::getDevices().size());
+    
+    trainAndSearch(som);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testList();
+    testFind();
+    testSelection();
+    testFastest();
+    
+    return 0;
+}
@@ -0,0 +1,128 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstring>
+#include "model.hpp"
+#include "trainer.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+#include "native_kernels.hpp"
+
+using namespace som;
+using namespace std;
+
+// Checks the BMU of every online step against the full scan
+class CheckedComputing : public NativeComputing {
+    
+public:
+    CheckedComputing(Model &model) : NativeComputing(model), stepsCount(0), mismatchesCount(0), model_(model), vector_(nullptr) {}
+    
+    size_t bmuIndex(const cl_float &vector, bool accumulateDistances, cl_float &distance) {
+        vector_ = &vector;
+        
+        return NativeComputing::bmuIndex(vector, accumulateDistances, distance);
+    }
+    
+    bool nodeDistances(const cl_float &vector, const cl_uint *nodes, const size_t count, cl_float *distances) {
+        vector_ = &vector;
+        
+        return NativeComputing::nodeDistances(vector, nodes, count, distances);
+    }
+    
+    void adjustWeights(const size_t bmuIndex, const double neighbourhoodRadius, const double learningRate, const double cutoffRadius) {
+        cl_float distance;
+        auto expectedIndex = scalarKernels().bmu[model_.getMetric()](vector_, &model_.getWeights(), model_.getChannelsCount(), 0, model_.getNodesCount(), distance);
+        
+        stepsCount++;
+        mismatchesCount += bmuIndex != expectedIndex;
+        
+        NativeComputing::adjustWeights(bmuIndex, neighbourhoodRadius, learningRate, cutoffRadius);
+    }
+    
+    size_t stepsCount;
+    size_t mismatchesCount;
+    
+private:
+    Model &model_;
+    const cl_float *vector_;
+};
+
+vector<vector<cl_float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<cl_float>> data(count, vector<cl_float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// An ordered map in its late training, most of the searches stay local
+void testLateTraining() {
+    const auto channels = 2;
+    const auto dataCount = 400;
+    
+    Model model(20, 16, channels, 5);
+    model.prepare(randomData(dataCount, channels), NO_NORM, RANDOM_FROM_DATA);
+    
+    CheckedComputing computing(model);
+    Trainer trainer(model, computing);
+    trainer.learn(20000, 0.2, false, ONLINE);
+    
+    assert(trainer.getLocalSearchesCount() == 0);
+    
+    trainer.setFastWinnerSearch(true);
+    trainer.learn(4000, 0.02, true, ONLINE);
+    
+    computing.stepsCount = 0;
+    computing.mismatchesCount = 0;
+    
+    while (!trainer.epoch()) {}
+    
+    auto localSearchesCount = trainer.getLocalSearchesCount();
+    auto fallbacksCount = trainer.getFallbacksCount();
+    
+    assert(computing.stepsCount == 4000);
+    assert(localSearchesCount > 2000);
+    assert(fallbacksCount < localSearchesCount / 2);
+    assert(computing.mismatchesCount < (localSearchesCount - fallbacksCount) / 20);
+}
+
+// Without a faster path the OpenCL backend searches every node
+void testFullSearchBackend() {
+    const auto channels = 4;
+    const auto dataCount = 30;
+    
+    Model model(6, 5, channels, 5);
+    model.prepare(randomData(dataCount, channels), NO_NORM, RANDOM_FROM_DATA);
+    
+    CLComputing computing(model, ALL_DEVICES);
+    Trainer trainer(model, computing);
+    trainer.setFastWinnerSearch(true);
+    trainer.learn(300, 0.1, false, ONLINE);
+    
+    assert(trainer.getLocalSearchesCount() == 0);
+    assert(trainer.getFallbacksCount() == 0);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testLateTraining();
+    testFullSearchBackend();
+    
+    return 0;
+}
@@ -0,0 +1,212 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <math.h>
+#include <vector>
+#include <thread>
+#include "som.hpp"
+#include "frozen_som.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(float a, float b, float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon);
+}
+
+vector<vector<float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<float>> data(count, vector<float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+void train(SOM &som, const vector<vector<float>> &data, const Normalization normalization, const DistanceMetric metric) {
+    assert(som.create(10, 8, 5, data[0].size()));
+    
+    som.prepare(data, normalization, RANDOM_FROM_DATA);
+    som.train(2, 0.3, metric);
+    
+    vector<int> labels;
+    vector<size_t> nodes;
+    
+    for (auto i = 0; i < 10 * 8; i++) {
+        labels.push_back(i % 7);
+        nodes.push_back(i);
+    }
+    
+    som.setLabels(labels, nodes);
+}
+
+// The frozen copy, and the copy loaded from the save file, find the BMUs and labels of the map
+void testFreeze(const DistanceMetric metric) {
+    const auto channels = 6;
+    
+    auto data = randomData(50, channels);
+    auto queries = randomData(100, channels);
+    
+    SOM som(NATIVE);
+    train(som, data, MINMAX_BY_COLUMNS, metric);
+    
+    auto frozen = som.freeze();
+    
+    assert(frozen && !frozen->hasNorms());
+    assert(frozen->getNodeDimensionality() == channels);
+    assert(frozen->getNodesCount() == 10 * 8);
+    assert(frozen->getMetric() == metric);
+    
+    assert(som.save("frozen.som"));
+    
+    FrozenSOM loaded;
+    assert(loaded.load("frozen.som"));
+    
+    vector<float> batch;
+    
+    for (auto &vector : queries) {
+        batch.insert(batch.end(), vector.begin(), vector.end());
+    }
+    
+    vector<int> labels(queries.size());
+    frozen->predictBatch(batch.data(), queries.size(), labels.data());
+    
+    for (auto i = 0; i < queries.size(); i++) {
+        auto bmuIndex = som.computeBmuIndex(queries[i]);
+        
+        assert(frozen->computeBmuIndex(queries[i]) == bmuIndex);
+        assert(loaded.computeBmuIndex(queries[i]) == bmuIndex);
+        assert(frozen->predict(queries[i]) == som.predict(queries[i]));
+        assert(loaded.predict(queries[i]) == som.predict(queries[i]));
+        assert(labels[i] == som.predict(queries[i]));
+    }
+    
+    delete frozen;
+    remove("frozen.som");
+}
+
+float distance(const vector<float> &vector, const float *weights, const DistanceMetric metric) {
+    double dot = 0, vectorNorm = 0, weightsNorm = 0, squaredSum = 0;
+    
+    for (auto i = 0; i < vector.size(); i++) {
+        dot += vector[i] * weights[i];
+        vectorNorm += vector[i] * vector[i];
+        weightsNorm += weights[i] * weights[i];
+        squaredSum += (vector[i] - weights[i]) * (vector[i] - weights[i]);
+    }
+    
+    return metric == COSINE ? 1.0 - dot / (sqrt(vectorNorm) * sqrt(weightsNorm)) : squaredSum;
+}
+
+// The searches through the node norms find nodes at the distance of the BMU
+void testNorms(const DistanceMetric metric) {
+    const auto channels = 12;
+    
+    auto data = randomData(50, channels);
+    auto queries = randomData(200, channels);
+    
+    SOM som(NATIVE);
+    train(som, data, NO_NORM, metric);
+    
+    auto frozen = som.freeze(true);
+    auto cells = som.getCells();
+    
+    assert(frozen->hasNorms());
+    
+    for (auto &query : queries) {
+        auto index = frozen->computeBmuIndex(query);
+        auto bmuIndex = som.computeBmuIndex(query);
+        
+        assert(cmpf(distance(query, cells[index].weights, metric), distance(query, cells[bmuIndex].weights, metric)));
+    }
+    
+    delete frozen;
+}
+
+// Metrics without a norm search keep the direct one
+void testWithoutNorms() {
+    auto data = randomData(50, 4);
+    
+    SOM som(NATIVE);
+    train(som, data, NO_NORM, MANHATTAN);
+    
+    auto frozen = som.freeze(true);
+    
+    assert(!frozen->hasNorms());
+    
+    delete frozen;
+}
+
+// Any number of threads predict with the same frozen map
+void testThreads() {
+    const auto channels = 8;
+    
+    auto data = randomData(50, channels);
+    auto queries = randomData(300, channels);
+    
+    SOM som(NATIVE);
+    train(som, data, MINMAX_BY_COLUMNS, EUCLIDEAN);
+    
+    auto frozen = som.freeze(true);
+    
+    vector<int> expected;
+    
+    for (auto &query : queries) {
+        expected.push_back(frozen->predict(query));
+    }
+    
+    vector<thread> threads;
+    vector<size_t> mismatches(4, 0);
+    
+    for (auto t = 0; t < mismatches.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (auto i = 0; i < queries.size(); i++) {
+                mismatches[t] += frozen->predict(queries[i]) != expected[i];
+            }
+        });
+    }
+    
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    
+    for (auto count : mismatches) {
+        assert(count == 0);
+    }
+    
+    delete frozen;
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    for (auto metric : {EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, CANBERRA, COSINE, SAD, SSD, MAE, MSE}) {
+        testFreeze(metric);
+    }
+    
+    for (auto metric : {EUCLIDEAN, SSD, MSE, COSINE}) {
+        testNorms(metric);
+    }
+    
+    testWithoutNorms();
+    testThreads();
+    
+    FrozenSOM missing;
+    assert(!missing.load("missing.som"));
+    
+    return 0;
+}
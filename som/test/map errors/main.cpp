@@ -0,0 +1,130 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include <float.h>
+#include "model.hpp"
+#include "neighbourhood.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(double a, double b, double epsilon = 0.0005) {
+    return (fabs(a - b) < epsilon * max(1.0, fabs(b)));
+}
+
+// Host reference from the distances of every vector, one query at a time
+void expectedErrors(Computing &computing, Model &model, double &quantizationError, double &topographicError) {
+    const auto channels = model.getChannelsCount();
+    const auto nodesCount = model.getNodesCount();
+    const auto dataCount = model.getDataCount();
+    const cl_float *points = &model.getPoints();
+    
+    auto spacing = model.getNeighbourhood().getSquaredSpacing();
+    
+    quantizationError = 0;
+    topographicError = 0;
+    
+    for (auto i = 0; i < dataCount; i++) {
+        computing.bmuIndex((&model.getData())[i * channels], false);
+        cl_float *distances = &computing.weightDistances();
+        
+        size_t bmu = 0, second = 1;
+        
+        for (auto j = 0; j < nodesCount; j++) {
+            if (distances[j] < distances[bmu] || (j < bmu && distances[j] == distances[bmu])) {
+                bmu = j;
+            }
+        }
+        
+        second = bmu == 0 ? 1 : 0;
+        
+        for (auto j = 0; j < nodesCount; j++) {
+            if (j != bmu && distances[j] < distances[second]) {
+                second = j;
+            }
+        }
+        
+        auto dx = points[bmu * 2] - points[second * 2];
+        auto dy = points[bmu * 2 + 1] - points[second * 2 + 1];
+        
+        quantizationError += distances[bmu];
+        topographicError += dx * dx + dy * dy > 1.5 * spacing ? 1 : 0;
+    }
+    
+    quantizationError /= dataCount;
+    topographicError /= dataCount;
+}
+
+// The device and the native single pass against the reference
+void test(const DistanceMetric metric) {
+    const auto cols = 12;
+    const auto rows = 9;
+    const auto channels = 5;
+    const auto hexSize = 5;
+    const auto dataCount = 500;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model model(cols, rows, channels, hexSize);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    model.setMetric(metric);
+    
+    CLComputing computing(model, ALL_DEVICES);
+    NativeComputing nativeComputing(model);
+    
+    // Partly trained, so the topographic error is neither 0 nor 1
+    for (auto i = 0; i < 200; i++) {
+        auto &vector = model.getRandomDataVector();
+        auto bmuIndex = computing.bmuIndex(vector, false);
+        
+        computing.adjustWeights(bmuIndex, 20.0 * exp(-i / 60.0), 0.3);
+    }
+    
+    computing.readModel();
+    
+    double expectedQuantizationError, expectedTopographicError;
+    expectedErrors(computing, model, expectedQuantizationError, expectedTopographicError);
+    
+    for (Computing *backend : {(Computing *)&computing, (Computing *)&nativeComputing}) {
+        double quantizationError, topographicError;
+        backend->errors(quantizationError, topographicError);
+        
+        assert(cmpf(quantizationError, expectedQuantizationError));
+        assert(fabs(topographicError - expectedTopographicError) <= 2.0 / dataCount);
+        assert(cmpf(backend->error(), quantizationError));
+        
+        // A subsample is drawn from the same vectors
+        backend->errors(quantizationError, topographicError, 50);
+        
+        assert(quantizationError > 0 && quantizationError < FLT_MAX);
+        assert(topographicError >= 0 && topographicError <= 1);
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    for (auto metric : {EUCLIDEAN, MANHATTAN, CHEBYSHEV, COSINE}) {
+        test(metric);
+    }
+    
+    return 0;
+}
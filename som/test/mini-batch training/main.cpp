@@ -0,0 +1,183 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <assert.h>
+#include <cstring>
+#include "som.hpp"
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon);
+}
+
+// The default batch size with an ordinary learning rate sums the influences well past 1 early in the training,
+// the nodes still only move towards the batch means and stay within the range of the data
+void testTraining(const Device device) {
+    const auto channels = 3;
+    
+    vector<vector<float>> data(500, vector<float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    SOM som(device);
+    som.create(20, 20, 5, channels);
+    som.prepare(data);
+    som.train(5000, 0.2, EUCLIDEAN, false, MINI_BATCH);
+    
+    for (auto &cell : som.getCells()) {
+        for (auto j = 0; j < channels; j++) {
+            assert(cell.weights[j] >= 0.0f && cell.weights[j] <= 1.0f);
+        }
+    }
+    
+    double quantizationError, topographicError;
+    som.computeErrors(quantizationError, topographicError);
+    
+    assert(quantizationError < 0.15);
+}
+
+int main(int argc, const char * argv[]) {
+    // Create model
+    const auto cols = 10;
+    const auto rows = 8;
+    const auto channels = 3;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto batchSize = 16;
+    
+    srand(1);
+    
+    Model model(cols, rows, channels, hexSize);
+    model.setMetric(EUCLIDEAN);
+    
+    cl_float *weights = &model.getWeights();
+    cl_float *points = &model.getPoints();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        weights[i] = (cl_float)rand() / RAND_MAX;
+    }
+    
+    vector<cl_float> vectors(batchSize * channels);
+    vector<cl_float> schedule(batchSize * 2);
+    
+    for (auto &value : vectors) {
+        value = (cl_float)rand() / RAND_MAX;
+    }
+    
+    for (auto i = 0; i < batchSize; i++) {
+        schedule[i * 2] = 30.0f - i;
+        schedule[i * 2 + 1] = 0.1f - 0.005f * i;
+    }
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    // BMUs against the weights before the step
+    vector<size_t> bmuIndices(batchSize);
+    computing.bmuIndices(vectors[0], batchSize, bmuIndices.data());
+    
+    // Host reference of the step towards the influence-weighted means, capped at the means
+    vector<cl_float> expectedWeights(weights, weights + nodesCount * channels);
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        cl_float influenceSum = 0;
+        vector<cl_float> weightedSum(channels, 0);
+        
+        for (auto s = 0; s < batchSize; s++) {
+            auto bmu = bmuIndices[s];
+            auto dx = points[bmu * 2] - points[i * 2];
+            auto dy = points[bmu * 2 + 1] - points[i * 2 + 1];
+            auto distance = dx * dx + dy * dy;
+            auto radius = schedule[s * 2];
+            
+            if (distance <= radius * radius) {
+                auto influence = schedule[s * 2 + 1] * exp(-distance / (2 * radius * radius));
+                
+                influenceSum += influence;
+                
+                for (auto j = 0; j < channels; j++) {
+                    weightedSum[j] += influence * vectors[s * channels + j];
+                }
+            }
+        }
+        
+        if (influenceSum > 0) {
+            for (auto j = 0; j < channels; j++) {
+                auto &weight = expectedWeights[i * channels + j];
+                weight += min(influenceSum, 1.0f) * (weightedSum[j] / influenceSum - weight);
+            }
+        }
+    }
+    
+    computing.adjustWeightsMiniBatch(vectors[0], batchSize, schedule[0]);
+    computing.readModel();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        assert(cmpf(weights[i], expectedWeights[i]));
+    }
+    
+    cl_int *activationStates = &model.getActivationStates();
+    
+    auto activationsCount = 0;
+    for (auto i = 0; i < nodesCount; i++) {
+        activationsCount += activationStates[i];
+    }
+    
+    assert(activationsCount == batchSize);
+    
+    // A single vector mini-batch is the online step
+    vector<cl_float> onlineWeights(weights, weights + nodesCount * channels);
+    
+    auto bmuIndex = computing.bmuIndex(vectors[0], false);
+    computing.adjustWeights(bmuIndex, schedule[0], schedule[1]);
+    computing.readModel();
+    
+    vector<cl_float> expectedOnlineWeights(weights, weights + nodesCount * channels);
+    
+    memcpy(weights, onlineWeights.data(), sizeof(cl_float) * nodesCount * channels);
+    computing.writeModel();
+    
+    computing.adjustWeightsMiniBatch(vectors[0], 1, schedule[0]);
+    computing.readModel();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        assert(cmpf(weights[i], expectedOnlineWeights[i]));
+    }
+    
+    // Large learning rates sum the influences past 1
+    for (auto i = 0; i < batchSize; i++) {
+        schedule[i * 2 + 1] = 0.5f;
+    }
+    
+    memcpy(weights, onlineWeights.data(), sizeof(cl_float) * nodesCount * channels);
+    computing.writeModel();
+    
+    computing.adjustWeightsMiniBatch(vectors[0], batchSize, schedule[0]);
+    computing.readModel();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        assert(weights[i] >= 0.0f && weights[i] <= 1.0f);
+    }
+    
+    for (auto device : {ALL_DEVICES, NATIVE}) {
+        testTraining(device);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,159 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <vector>
+#include <thread>
+#include "som_pack.hpp"
+#include "runtime.hpp"
+#include "devices.hpp"
+
+using namespace som;
+using namespace std;
+
+vector<vector<float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<float>> data(count, vector<float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// The models of a device share its context, and a program is built once per context
+void testRuntime() {
+    auto deviceId = Devices::find(ALL_DEVICES);
+    
+    if (!deviceId) {
+        return;
+    }
+    
+    auto context = Runtime::shared().context(deviceId);
+    
+    assert(context && context == Runtime::shared().context(deviceId));
+    
+    auto code = string("__kernel void copy(__global const float *a, __global float *b) { b[get_global_id(0)] = a[get_global_id(0)]; }");
+    
+    auto program = Runtime::shared().program(code, context, deviceId, "");
+    auto same = Runtime::shared().program(code, context, deviceId, "");
+    auto other = Runtime::shared().program(code, context, deviceId, "-DOTHER");
+    
+    assert(program && program == same);
+    assert(other && other != program);
+    
+    clReleaseProgram(program);
+    clReleaseProgram(same);
+    clReleaseProgram(other);
+    
+    // Requested at once, the program is built by one of the threads and handed to all of them
+    vector<cl_program> programs(4);
+    vector<thread> threads;
+    
+    for (auto &program : programs) {
+        threads.push_back(thread([&]() {
+            program = Runtime::shared().program(code, context, deviceId, "-DCONCURRENT");
+        }));
+    }
+    
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    
+    for (auto &program : programs) {
+        assert(program && program == programs[0]);
+        clReleaseProgram(program);
+    }
+}
+
+// Maps of different sizes searched together find the BMUs each of them finds alone
+void testPack(const Device device, const DistanceMetric metric) {
+    const auto channels = 5;
+    const size_t sizes[][2] = {{4, 3}, {7, 5}, {10, 8}, {2, 2}};
+    const auto somsCount = sizeof(sizes) / sizeof(sizes[0]);
+    
+    vector<SOM *> soms;
+    vector<const SOM *> packed;
+    
+    for (auto &size : sizes) {
+        auto som = new SOM(device);
+        auto data = randomData(40, channels);
+        
+        assert(som->create(size[0], size[1], 5, channels));
+        
+        som->prepare(data, MINMAX_BY_COLUMNS, RANDOM_FROM_DATA);
+        som->train(2, 0.2, metric);
+        
+        soms.push_back(som);
+        packed.push_back(som);
+    }
+    
+    SOMPack pack(packed);
+    
+    const auto count = 300;
+    auto vectors = randomData(count, channels);
+    
+    vector<float> data;
+    vector<size_t> somIndices(count);
+    vector<size_t> bmuIndices(count);
+    vector<int> labels(count);
+    
+    for (auto i = 0; i < count; i++) {
+        data.insert(data.end(), vectors[i].begin(), vectors[i].end());
+        somIndices[i] = rand() % somsCount;
+    }
+    
+    pack.computeBmuIndices(data.data(), somIndices.data(), count, bmuIndices.data());
+    pack.predictBatch(data.data(), somIndices.data(), count, labels.data());
+    
+    for (auto i = 0; i < count; i++) {
+        auto som = soms[somIndices[i]];
+        
+        assert(bmuIndices[i] == som->computeBmuIndex(vectors[i]));
+        assert(labels[i] == som->predict(vectors[i]));
+    }
+    
+    // An empty batch has nothing to search
+    pack.computeBmuIndices(nullptr, nullptr, 0, nullptr);
+    pack.predictBatch(nullptr, nullptr, 0, nullptr);
+    
+    // The pack follows the maps after update()
+    soms[1]->train(1, 0.5, metric);
+    pack.update();
+    
+    pack.computeBmuIndices(data.data(), somIndices.data(), count, bmuIndices.data());
+    
+    for (auto i = 0; i < count; i++) {
+        assert(bmuIndices[i] == soms[somIndices[i]]->computeBmuIndex(vectors[i]));
+    }
+    
+    for (auto som : soms) {
+        delete som;
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testRuntime();
+    
+    for (auto device : {ALL_DEVICES, NATIVE}) {
+        for (auto metric : {EUCLIDEAN, MANHATTAN, COSINE}) {
+            testPack(device, metric);
+        }
+    }
+    
+    return 0;
+}
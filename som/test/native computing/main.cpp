@@ -0,0 +1,207 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include <atomic>
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+#include "native_kernels.hpp"
+#include "thread_pool.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// The vectorized kernels with their remainder handling against the scalar ones
+void testInstructionSet(const NativeKernels &kernels) {
+    const auto &scalar = scalarKernels();
+    const size_t nodesCount = 37;
+    
+    for (auto channels : {1, 3, 8, 16, 21, 67}) {
+        vector<cl_float> vector(channels);
+        std::vector<cl_float> weights(nodesCount * channels);
+        
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+        
+        for (auto &value : weights) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+        
+        for (auto metric = 0; metric < DISTANCE_METRICS_COUNT; metric++) {
+            std::vector<cl_float> expected(nodesCount);
+            std::vector<cl_float> distances(nodesCount);
+            
+            scalar.distances[metric](vector.data(), weights.data(), channels, 0, nodesCount, expected.data());
+            kernels.distances[metric](vector.data(), weights.data(), channels, 0, nodesCount, distances.data());
+            
+            for (auto i = 0; i < nodesCount; i++) {
+                assert(cmpf(distances[i], expected[i]));
+            }
+            
+            cl_float expectedDistance, distance;
+            auto expectedIndex = scalar.bmu[metric](vector.data(), weights.data(), channels, 5, nodesCount, expectedDistance);
+            auto index = kernels.bmu[metric](vector.data(), weights.data(), channels, 5, nodesCount, distance);
+            
+            assert(index == expectedIndex);
+            assert(cmpf(distance, expectedDistance));
+        }
+    }
+}
+
+void testThreadPool() {
+    // Three workers and the calling thread
+    ThreadPool threadPool(3);
+    
+    assert(threadPool.getThreadsCount() == 4);
+    
+    for (auto count : {0, 1, 7, 1000}) {
+        vector<atomic<int>> visits(count);
+        
+        for (auto &visit : visits) {
+            visit = 0;
+        }
+        
+        threadPool.parallelFor(count, 10, [&](size_t begin, size_t end) {
+            assert(begin < end && end <= count);
+            
+            for (auto i = begin; i < end; i++) {
+                visits[i]++;
+            }
+        });
+        
+        for (auto &visit : visits) {
+            assert(visit == 1);
+        }
+    }
+}
+
+void assertModelsEqual(const Model &expected, const Model &model) {
+    const auto nodesCount = model.getNodesCount();
+    
+    for (auto i = 0; i < nodesCount * model.getChannelsCount(); i++) {
+        assert(cmpf((&model.getWeights())[i], (&expected.getWeights())[i]));
+    }
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        assert((&model.getActivationStates())[i] == (&expected.getActivationStates())[i]);
+        assert(cmpf((&model.getDistancesAccumulator())[i], (&expected.getDistancesAccumulator())[i]));
+    }
+}
+
+// The native backend against the OpenCL one
+void testComputing(const DistanceMetric metric) {
+    const auto cols = 9;
+    const auto rows = 7;
+    const auto channels = 5;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 200;
+    const auto batchSize = 8;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model expectedModel(cols, rows, channels, hexSize);
+    Model model(cols, rows, channels, hexSize);
+    
+    for (auto model : {&expectedModel, &model}) {
+        model->prepare(data, NO_NORM, RANDOM_0_1);
+        model->setMetric(metric);
+    }
+    
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * nodesCount * channels);
+    
+    CLComputing expectedComputing(expectedModel, ALL_DEVICES);
+    NativeComputing computing(model);
+    
+    // Online steps
+    for (auto i = 0; i < 20; i++) {
+        auto &vector = data[i];
+        auto accumulate = i % 2 == 0;
+        
+        cl_float expectedDistance, distance;
+        auto expectedIndex = expectedComputing.bmuIndex(vector[0], accumulate, expectedDistance);
+        auto index = computing.bmuIndex(vector[0], accumulate, distance);
+        
+        assert(index == expectedIndex);
+        assert(cmpf(distance, expectedDistance));
+        
+        cl_float *expectedDistances = &expectedComputing.weightDistances();
+        cl_float *distances = &computing.weightDistances();
+        
+        for (auto j = 0; j < nodesCount; j++) {
+            assert(cmpf(distances[j], expectedDistances[j]));
+        }
+        
+        expectedComputing.adjustWeights(index, 10.0 - i * 0.4, 0.1);
+        computing.adjustWeights(index, 10.0 - i * 0.4, 0.1);
+    }
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertModelsEqual(expectedModel, model);
+    
+    // Batched search
+    vector<size_t> expectedIndices(dataCount);
+    vector<size_t> indices(dataCount);
+    
+    expectedComputing.bmuIndices(expectedModel.getData(), dataCount, expectedIndices.data());
+    computing.bmuIndices(model.getData(), dataCount, indices.data());
+    
+    assert(indices == expectedIndices);
+    
+    // Batch and mini-batch steps
+    expectedComputing.adjustWeightsBatch(6.0);
+    computing.adjustWeightsBatch(6.0);
+    
+    vector<cl_float> schedule(batchSize * 2);
+    for (auto i = 0; i < batchSize; i++) {
+        schedule[i * 2] = 4.0f - i * 0.2f;
+        schedule[i * 2 + 1] = 0.05f;
+    }
+    
+    expectedComputing.adjustWeightsMiniBatch(expectedModel.getData(), batchSize, schedule[0]);
+    computing.adjustWeightsMiniBatch(model.getData(), batchSize, schedule[0]);
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertModelsEqual(expectedModel, model);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testThreadPool();
+    
+    for (auto kernels : {avx2Kernels(), avx512Kernels()}) {
+        if (kernels) {
+            testInstructionSet(*kernels);
+        }
+    }
+    
+    for (auto metric : {EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, CANBERRA, COSINE, SAD, SSD, MAE, MSE}) {
+        testComputing(metric);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,176 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include "som.hpp"
+#include "model.hpp"
+#include "neighbourhood.hpp"
+#include "influence_table.hpp"
+#include "rectangle_grid.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+static const NeighbourhoodFunction FUNCTIONS[] = {GAUSSIAN, BUBBLE, MEXICAN_HAT, CUT_GAUSSIAN, EPANECHNIKOV};
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// The table entries against the functions at every distance within the radius
+void testTable() {
+    RectangleGrid grid(15, 11, 5);
+    Neighbourhood neighbourhood(grid);
+    InfluenceTable table(neighbourhood);
+    
+    for (auto function : FUNCTIONS) {
+        for (auto radius : {0.5, 9.0, 23.7, 80.0}) {
+            table.update(function, radius);
+            
+            neighbourhood.visit(82, radius, [&](cl_uint index, cl_float squaredDistance) {
+                assert(cmpf(table(squaredDistance), InfluenceTable::influence(function, squaredDistance, radius * radius)));
+            });
+        }
+        
+        // The functions with a tail reach the threshold at the cutoff radius, the Gaussian is above 0.61 inside the radius
+        auto cutoffRadius = InfluenceTable::cutoffRadius(function, 10.0, 0.8);
+        auto influence = InfluenceTable::influence(function, cutoffRadius * cutoffRadius, 100.0f);
+        
+        assert(cutoffRadius <= 10.0);
+        assert(function == BUBBLE || function == MEXICAN_HAT || cmpf(influence, 0.8f));
+        assert(InfluenceTable::cutoffRadius(function, 10.0, 0.0) == 10.0);
+    }
+    
+    assert(cmpf(InfluenceTable::influence(CUT_GAUSSIAN, 100.0f, 100.0f), 0.0f));
+    assert(cmpf(InfluenceTable::influence(EPANECHNIKOV, 100.0f, 100.0f), 0.0f));
+    assert(InfluenceTable::influence(MEXICAN_HAT, 100.0f, 100.0f) < 0);
+}
+
+void assertWeightsEqual(const Model &expected, const Model &model) {
+    for (auto i = 0; i < model.getNodesCount() * model.getChannelsCount(); i++) {
+        assert(cmpf((&model.getWeights())[i], (&expected.getWeights())[i]));
+    }
+}
+
+// The OpenCL backend against the native one in every training mode
+void testComputing(const NeighbourhoodFunction function) {
+    const auto cols = 9;
+    const auto rows = 7;
+    const auto channels = 4;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 100;
+    const auto batchSize = 8;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model expectedModel(cols, rows, channels, hexSize);
+    Model model(cols, rows, channels, hexSize);
+    
+    for (auto model : {&expectedModel, &model}) {
+        model->prepare(data, NO_NORM, RANDOM_0_1);
+        model->setMetric(EUCLIDEAN);
+        model->setNeighbourhoodFunction(function);
+    }
+    
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * nodesCount * channels);
+    
+    CLComputing expectedComputing(expectedModel, ALL_DEVICES);
+    NativeComputing computing(model);
+    
+    for (auto i = 0; i < 20; i++) {
+        auto bmuIndex = expectedComputing.bmuIndex(data[i][0], false);
+        computing.bmuIndex(data[i][0], false);
+        
+        expectedComputing.adjustWeights(bmuIndex, 20.0 - i * 0.8, 0.1);
+        computing.adjustWeights(bmuIndex, 20.0 - i * 0.8, 0.1);
+    }
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertWeightsEqual(expectedModel, model);
+    
+    vector<cl_float> schedule(batchSize * 2);
+    for (auto i = 0; i < batchSize; i++) {
+        schedule[i * 2] = 12.0f - i;
+        schedule[i * 2 + 1] = 0.02f;
+    }
+    
+    expectedComputing.adjustWeightsMiniBatch(expectedModel.getData(), batchSize, schedule[0]);
+    computing.adjustWeightsMiniBatch(model.getData(), batchSize, schedule[0]);
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertWeightsEqual(expectedModel, model);
+    
+    expectedComputing.adjustWeightsBatch(15.0);
+    computing.adjustWeightsBatch(15.0);
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertWeightsEqual(expectedModel, model);
+}
+
+// The negative ring of the Mexican hat doesn't push the nodes out of the data in the Kohonen modes
+void testTraining(const NeighbourhoodFunction function, const Device device, const Training training) {
+    const auto channels = 3;
+    
+    vector<vector<float>> data(500, vector<float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (float)rand() / RAND_MAX;
+        }
+    }
+    
+    SOM som(device);
+    som.create(20, 20, 5, channels);
+    som.prepare(data);
+    som.setNeighbourhoodFunction(function);
+    som.train(5000, 0.2, EUCLIDEAN, false, training);
+    
+    for (auto &cell : som.getCells()) {
+        for (auto j = 0; j < channels; j++) {
+            assert(cell.weights[j] >= 0.0f && cell.weights[j] <= 1.0f);
+        }
+    }
+    
+    double quantizationError, topographicError;
+    som.computeErrors(quantizationError, topographicError);
+    
+    assert(topographicError < 0.2);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    testTable();
+    
+    for (auto function : FUNCTIONS) {
+        testComputing(function);
+    }
+    
+    for (auto device : {ALL_DEVICES, NATIVE}) {
+        for (auto training : {ONLINE, MINI_BATCH}) {
+            testTraining(MEXICAN_HAT, device, training);
+        }
+    }
+    
+    return 0;
+}
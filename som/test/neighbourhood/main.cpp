@@ -0,0 +1,87 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include "neighbourhood.hpp"
+#include "hexagon_grid.hpp"
+#include "rectangle_grid.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// The table and the stencil against the distances of the grid points
+void test(const Grid &grid, const size_t maxTableNodes) {
+    Neighbourhood neighbourhood(grid, maxTableNodes);
+    
+    assert(neighbourhood.hasTable() == (grid.getNodesCount() <= maxTableNodes));
+    
+    const auto nodesCount = grid.getNodesCount();
+    cl_float *points = &grid.getPoints();
+    
+    for (auto node = 0; node < nodesCount; node += 3) {
+        vector<cl_float> expected(nodesCount);
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            cl_float dx = points[node * 2] - points[i * 2];
+            cl_float dy = points[node * 2 + 1] - points[i * 2 + 1];
+            
+            expected[i] = dx * dx + dy * dy;
+        }
+        
+        vector<cl_float> distances(nodesCount);
+        neighbourhood.squaredDistances(node, distances.data());
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            assert(cmpf(distances[i], expected[i]));
+        }
+        
+        for (auto radius : {0.0, 1.0, 4.5, 9.0, 13.0, 1000.0}) {
+            vector<bool> visited(nodesCount, false);
+            cl_float lastDistance = 0;
+            
+            neighbourhood.visit(node, radius, [&](cl_uint index, cl_float squaredDistance) {
+                assert(!visited[index]);
+                assert(squaredDistance >= lastDistance);
+                
+                visited[index] = true;
+                lastDistance = squaredDistance;
+            });
+            
+            for (auto i = 0; i < nodesCount; i++) {
+                auto squareRadius = radius * radius;
+                
+                if (fabs(expected[i] - squareRadius) > 0.01) {
+                    assert(visited[i] == (expected[i] <= squareRadius));
+                }
+            }
+            
+            assert(visited[node]);
+        }
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    RectangleGrid rectangleGrid(11, 7, 5);
+    HexagonGrid hexagonGrid(5, 5);
+    
+    for (auto maxTableNodes : {Neighbourhood::MAX_TABLE_NODES, (size_t)0}) {
+        test(rectangleGrid, maxTableNodes);
+        test(hexagonGrid, maxTableNodes);
+    }
+    
+    return 0;
+}
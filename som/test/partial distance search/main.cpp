@@ -0,0 +1,138 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstring>
+#include <float.h>
+#include "model.hpp"
+#include "native_computing.hpp"
+#include "native_kernels.hpp"
+
+using namespace som;
+using namespace std;
+
+static const DistanceMetric monotoneMetrics[] = {EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, SAD, SSD, MAE, MSE};
+
+// The bounded search against the full one, bounded by the distance of every node in turn
+void testKernels(const NativeKernels &kernels) {
+    const size_t nodesCount = 41;
+    
+    assert(!kernels.boundedBmu[CANBERRA] && !kernels.boundedBmu[COSINE]);
+    
+    for (auto channels : {1, 7, 64, 67, 300}) {
+        vector<cl_float> vector(channels);
+        std::vector<cl_float> weights(nodesCount * channels);
+        
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+        
+        for (auto &value : weights) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+        
+        // Ties with a lower node
+        memcpy(&weights[3 * channels], &weights[30 * channels], sizeof(cl_float) * channels);
+        
+        for (auto metric : monotoneMetrics) {
+            cl_float expectedDistance;
+            auto expectedIndex = kernels.bmu[metric](vector.data(), weights.data(), channels, 0, nodesCount, expectedDistance);
+            
+            for (auto seed = 0; seed < nodesCount; seed++) {
+                cl_float distance;
+                kernels.bmu[metric](vector.data(), weights.data(), channels, seed, seed + 1, distance);
+                
+                auto index = kernels.boundedBmu[metric](vector.data(), weights.data(), channels, 0, nodesCount, distance);
+                
+                assert(index == expectedIndex);
+                assert(distance == expectedDistance);
+            }
+            
+            // Every node is abandoned below the lowest distance
+            cl_float bound = expectedDistance * 0.5f;
+            auto index = kernels.boundedBmu[metric](vector.data(), weights.data(), channels, 0, nodesCount, bound);
+            
+            assert(expectedDistance == 0.0f || (index == SIZE_MAX && bound == expectedDistance * 0.5f));
+        }
+    }
+}
+
+// The partial distance search of the backend against its full scan
+void testComputing(const DistanceMetric metric) {
+    const auto cols = 12;
+    const auto rows = 9;
+    const auto channels = 256;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 150;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model model(cols, rows, channels, hexSize);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    model.setMetric(metric);
+    
+    cl_float *weights = &model.getWeights();
+    
+    // Duplicated nodes, the lower index has to win the tie whatever the seed
+    memcpy(&weights[2 * channels], &weights[70 * channels], sizeof(cl_float) * channels);
+    memcpy(&data[5][0], &weights[70 * channels], sizeof(cl_float) * channels);
+    memcpy(&(&model.getData())[5 * channels], &weights[70 * channels], sizeof(cl_float) * channels);
+    
+    NativeComputing computing(model);
+    NativeComputing expectedComputing(model);
+    expectedComputing.setPartialDistanceSearch(false);
+    
+    for (auto &vector : data) {
+        cl_float expectedDistance, distance;
+        auto expectedIndex = expectedComputing.bmuIndex(vector[0], false, expectedDistance);
+        auto index = computing.bmuIndex(vector[0], false, distance);
+        
+        assert(index == expectedIndex);
+        assert(distance == expectedDistance);
+    }
+    
+    vector<size_t> expectedIndices(dataCount);
+    vector<size_t> indices(dataCount);
+    
+    expectedComputing.bmuIndices(model.getData(), dataCount, expectedIndices.data());
+    computing.bmuIndices(model.getData(), dataCount, indices.data());
+    
+    assert(indices == expectedIndices);
+    assert(indices[5] == 2);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    for (auto kernels : {&scalarKernels(), avx2Kernels(), avx512Kernels()}) {
+        if (kernels) {
+            testKernels(*kernels);
+        }
+    }
+    
+    for (auto metric : monotoneMetrics) {
+        testComputing(metric);
+    }
+    
+    // The other metrics fall back to the full scan
+    testComputing(CANBERRA);
+    testComputing(COSINE);
+    
+    return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <dirent.h>
+#include <stdio.h>
+#include "program_cache.hpp"
+
+using namespace som;
+using namespace std;
+
+static const string CODE = "__kernel void twice(__global float *values)"
+                           "{"
+                           "    int id = get_global_id(0);"
+                           "    values[id] *= 2;"
+                           "}";
+
+vector<string> entries(const string &directory) {
+    vector<string> result;
+    DIR *dir = opendir(directory.c_str());
+    
+    if (dir) {
+        while (dirent *entry = readdir(dir)) {
+            string name = entry->d_name;
+            
+            if (name != "." && name != "..") {
+                result.push_back(directory + "/" + name);
+            }
+        }
+        
+        closedir(dir);
+    }
+    
+    return result;
+}
+
+void clear(const string &directory) {
+    for (auto &entry : entries(directory)) {
+        remove(entry.c_str());
+    }
+}
+
+string read(const string &path) {
+    ifstream file(path, ios::binary);
+    stringstream stream;
+    stream << file.rdbuf();
+    
+    return stream.str();
+}
+
+void write(const string &path, const string &content) {
+    ofstream file(path, ios::binary | ios::trunc);
+    file << content;
+}
+
+// Builds the test program and checks that its kernel runs
+void buildAndRun(cl_context &context, cl_command_queue &commandQueue, cl_device_id &deviceId) {
+    cl_program program = ProgramCache::build(CODE, context, deviceId);
+    assert(program);
+    
+    cl_kernel kernel = clCreateKernel(program, "twice", nullptr);
+    assert(kernel);
+    
+    vector<cl_float> values = {1, 2, 3, 4};
+    size_t globalWorkSize[1] = {values.size()};
+    
+    cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(cl_float) * values.size(), values.data(), nullptr);
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &buffer);
+    clEnqueueNDRangeKernel(commandQueue, kernel, 1, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+    clEnqueueReadBuffer(commandQueue, buffer, CL_TRUE, 0, sizeof(cl_float) * values.size(), values.data(), 0, nullptr, nullptr);
+    
+    for (auto i = 0; i < values.size(); i++) {
+        assert(values[i] == 2 * (i + 1));
+    }
+    
+    clReleaseMemObject(buffer);
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+}
+
+int main(int argc, const char * argv[]) {
+    cl_platform_id platforms = nullptr;
+    cl_uint num_platforms, num_devices;
+    clGetPlatformIDs(1, &platforms, &num_platforms);
+    
+    cl_device_id deviceId = nullptr;
+    assert(clGetDeviceIDs(platforms, CL_DEVICE_TYPE_ALL, 1, &deviceId, &num_devices) == CL_SUCCESS);
+    
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_command_queue commandQueue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+    
+    const string directory = "program cache entries";
+    
+    ProgramCache::setDirectory(directory);
+    clear(directory);
+    
+    // Disabled, nothing is stored
+    ProgramCache::setEnabled(false);
+    buildAndRun(context, commandQueue, deviceId);
+    assert(entries(directory).empty());
+    
+    // The first build stores the binary
+    ProgramCache::setEnabled(true);
+    buildAndRun(context, commandQueue, deviceId);
+    
+    auto stored = entries(directory);
+    assert(stored.size() == 1);
+    
+    auto path = stored[0];
+    auto entry = read(path);
+    
+    // The second one is loaded from it and leaves it as it is
+    buildAndRun(context, commandQueue, deviceId);
+    assert(entries(directory).size() == 1);
+    assert(read(path) == entry);
+    
+    // An entry of another driver version is stale and replaced
+    auto identityEnd = entry.find('\n', entry.find('\n') + 1);
+    write(path, entry.substr(0, identityEnd) + " | old driver" + entry.substr(identityEnd));
+    
+    buildAndRun(context, commandQueue, deviceId);
+    assert(entries(directory).size() == 1);
+    assert(read(path) == entry);
+    
+    // So is a damaged one
+    write(path, entry.substr(0, entry.size() / 2));
+    
+    buildAndRun(context, commandQueue, deviceId);
+    assert(read(path) == entry);
+    
+    clear(directory);
+    
+    clReleaseCommandQueue(commandQueue);
+    clReleaseContext(context);
+    
+    return 0;
+}
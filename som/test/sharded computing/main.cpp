@@ -0,0 +1,292 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstring>
+#include <vector>
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "sharded_computing.hpp"
+#include "devices.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+vector<vector<cl_float>> randomData(const size_t count, const size_t channels) {
+    vector<vector<cl_float>> data(count, vector<cl_float>(channels));
+    
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    return data;
+}
+
+// The ranges cover the map without gaps, in order
+void testRanges(const ShardedComputing &computing, const size_t shardsCount, const size_t nodesCount) {
+    assert(computing.getShardsCount() == shardsCount);
+    assert(computing.getShardBegin(0) == 0);
+    assert(computing.getShardEnd(shardsCount - 1) == nodesCount);
+    
+    for (auto i = 0; i < shardsCount; i++) {
+        assert(computing.getShardBegin(i) < computing.getShardEnd(i));
+        
+        if (i > 0) {
+            assert(computing.getShardBegin(i) == computing.getShardEnd(i - 1));
+        }
+    }
+}
+
+// The merged searches against a single device holding the whole map
+void testSearches(const vector<cl_device_id> &devices, const DistanceMetric metric, const WeightsLayout layout) {
+    const auto cols = 17;
+    const auto rows = 12;
+    const auto channels = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 60;
+    
+    Model model(cols, rows, channels, 5);
+    model.prepare(randomData(dataCount, channels), NO_NORM, RANDOM_0_1);
+    model.setMetric(metric);
+    
+    CLComputing computing(model, ALL_DEVICES, layout);
+    ShardedComputing shardedComputing(model, devices);
+    
+    testRanges(shardedComputing, devices.size(), nodesCount);
+    
+    cl_float *data = &model.getData();
+    
+    for (auto i = 0; i < dataCount; i++) {
+        cl_float distance, shardedDistance;
+        
+        auto bmuIndex = computing.bmuIndex(data[i * channels], false, distance);
+        vector<cl_float> weightDistances(&computing.weightDistances(), &computing.weightDistances() + nodesCount);
+        
+        assert(shardedComputing.bmuIndex(data[i * channels], false, shardedDistance) == bmuIndex);
+        assert(cmpf(shardedDistance, distance));
+        
+        cl_float *shardedWeightDistances = &shardedComputing.weightDistances();
+        
+        for (auto j = 0; j < nodesCount; j++) {
+            assert(cmpf(shardedWeightDistances[j], weightDistances[j]));
+        }
+    }
+    
+    vector<size_t> bmuIndices(dataCount), shardedBmuIndices(dataCount);
+    
+    computing.bmuIndices(data[0], dataCount, bmuIndices.data());
+    shardedComputing.bmuIndices(data[0], dataCount, shardedBmuIndices.data());
+    
+    assert(bmuIndices == shardedBmuIndices);
+    
+    // Within the device reduction and above it
+    for (size_t k : {2, 7, 20}) {
+        vector<size_t> indices(dataCount * k), shardedIndices(dataCount * k);
+        vector<cl_float> distances(dataCount * k), shardedDistances(dataCount * k);
+        
+        computing.topK(data[0], dataCount, k, indices.data(), distances.data());
+        shardedComputing.topK(data[0], dataCount, k, shardedIndices.data(), shardedDistances.data());
+        
+        for (auto i = 0; i < dataCount * k; i++) {
+            assert(shardedIndices[i] == indices[i]);
+            assert(cmpf(shardedDistances[i], distances[i]));
+        }
+    }
+    
+    double quantizationError, topographicError, shardedQuantizationError, shardedTopographicError;
+    
+    computing.errors(quantizationError, topographicError);
+    shardedComputing.errors(shardedQuantizationError, shardedTopographicError);
+    
+    assert(cmpf(shardedQuantizationError, quantizationError));
+    assert(cmpf(shardedTopographicError, topographicError));
+}
+
+// Copies the weights of one Model into the other, so both backends start from the same map
+void copyWeights(const Model &source, Model &destination, Computing &computing) {
+    auto size = source.getNodesCount() * source.getChannelsCount() * sizeof(cl_float);
+    
+    memcpy(&destination.getWeights(), &source.getWeights(), size);
+    memset(&destination.getDistancesAccumulator(), 0, source.getNodesCount() * sizeof(cl_float));
+    memset(&destination.getActivationStates(), 0, source.getNodesCount() * sizeof(cl_int));
+    
+    computing.writeModel();
+}
+
+void compareModels(const Model &model, const Model &shardedModel) {
+    auto nodesCount = model.getNodesCount();
+    auto channels = model.getChannelsCount();
+    
+    cl_float *weights = &model.getWeights();
+    cl_float *shardedWeights = &shardedModel.getWeights();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        assert(cmpf(shardedWeights[i], weights[i], 0.001f));
+    }
+    
+    cl_float *accumulator = &model.getDistancesAccumulator();
+    cl_float *shardedAccumulator = &shardedModel.getDistancesAccumulator();
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        assert(cmpf(shardedAccumulator[i], accumulator[i], 0.001f));
+        assert((&shardedModel.getActivationStates())[i] == (&model.getActivationStates())[i]);
+    }
+}
+
+// The online, batch and mini-batch steps of the shards against a single device
+void testTraining(const vector<cl_device_id> &devices, const WeightsLayout layout) {
+    const auto cols = 15;
+    const auto rows = 10;
+    const auto channels = 3;
+    const auto dataCount = 50;
+    const auto data = randomData(dataCount, channels);
+    
+    Model model(cols, rows, channels, 5);
+    Model shardedModel(cols, rows, channels, 5);
+    
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    shardedModel.prepare(data, NO_NORM, RANDOM_0_1);
+    
+    CLComputing computing(model, ALL_DEVICES, layout);
+    ShardedComputing shardedComputing(shardedModel, devices);
+    
+    copyWeights(shardedModel, model, computing);
+    copyWeights(shardedModel, shardedModel, shardedComputing);
+    
+    cl_float *vectors = &model.getData();
+    
+    for (auto i = 0; i < 30; i++) {
+        auto &vector = vectors[(i * 7 % dataCount) * channels];
+        auto radius = 6.0 - i * 0.15;
+        
+        auto bmuIndex = computing.bmuIndex(vector, true);
+        assert(shardedComputing.bmuIndex(vector, true) == bmuIndex);
+        
+        computing.adjustWeights(bmuIndex, radius, 0.3, radius * 0.6);
+        shardedComputing.adjustWeights(bmuIndex, radius, 0.3, radius * 0.6);
+    }
+    
+    computing.readModel();
+    shardedComputing.readModel();
+    compareModels(model, shardedModel);
+    
+    computing.adjustWeightsBatch(4);
+    shardedComputing.adjustWeightsBatch(4);
+    
+    computing.readModel();
+    shardedComputing.readModel();
+    compareModels(model, shardedModel);
+    
+    const auto batchSize = 8;
+    vector<cl_float> schedule(batchSize * 2);
+    
+    for (auto step = 0; step < 4; step++) {
+        for (auto i = 0; i < batchSize; i++) {
+            schedule[i * 2] = 3 - step * 0.5;
+            schedule[i * 2 + 1] = 0.2;
+        }
+        
+        auto &batch = vectors[step * batchSize * channels];
+        
+        computing.adjustWeightsMiniBatch(batch, batchSize, schedule[0]);
+        shardedComputing.adjustWeightsMiniBatch(batch, batchSize, schedule[0]);
+        
+        computing.finish();
+        shardedComputing.finish();
+    }
+    
+    computing.readModel();
+    shardedComputing.readModel();
+    compareModels(model, shardedModel);
+    
+    // The bounds move on the trained weights without losing any node
+    shardedComputing.balance();
+    shardedComputing.readModel();
+    
+    testRanges(shardedComputing, devices.size(), cols * rows);
+    compareModels(model, shardedModel);
+}
+
+// The online steps of a shard move the nodes of its range only, also where the neighbourhood
+// reaches over the bounds. The device copy is read back whole by widening the range afterwards.
+void testShardUpdates(const cl_device_id device, const size_t cols, const size_t rows, const WeightsLayout layout) {
+    const auto channels = 3;
+    const auto nodesCount = cols * rows;
+    const auto begin = nodesCount / 3;
+    const auto end = nodesCount * 2 / 3;
+    
+    Model model(cols, rows, channels, 5);
+    model.prepare(randomData(20, channels), NO_NORM, RANDOM_0_1);
+    
+    CLComputing computing(model, device, begin, end, layout);
+    computing.writeModel();
+    
+    vector<cl_float> weights(&model.getWeights(), &model.getWeights() + nodesCount * channels);
+    
+    // Around both bounds and at the far ends of the map
+    for (size_t bmuIndex : {(size_t)0, begin - 1, begin, end - 1, end, nodesCount - 1}) {
+        computing.adjustWeights(bmuIndex, 6, 0.3, 6);
+    }
+    
+    computing.setNodesRange(0, nodesCount);
+    computing.readModel();
+    
+    cl_float *updatedWeights = &model.getWeights();
+    size_t updatedCount = 0;
+    
+    for (auto i = 0; i < nodesCount; i++) {
+        bool updated = false;
+        
+        for (auto j = 0; j < channels; j++) {
+            updated |= updatedWeights[i * channels + j] != weights[i * channels + j];
+        }
+        
+        assert(!updated || (i >= begin && i < end));
+        updatedCount += updated;
+    }
+    
+    assert(updatedCount > 0);
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    auto devices = Devices::ids();
+    
+    // A device listed more than once holds several shards, so the merge runs on a single device too
+    for (auto shardsCount : {2, 3}) {
+        vector<cl_device_id> shardDevices(shardsCount, devices[0]);
+        
+        for (auto layout : {NODE_MAJOR, CHANNEL_MAJOR}) {
+            for (auto metric : {EUCLIDEAN, MANHATTAN, COSINE}) {
+                testSearches(shardDevices, metric, layout);
+            }
+            
+            testTraining(shardDevices, layout);
+        }
+    }
+    
+    // The table rows and the stencil
+    for (auto layout : {NODE_MAJOR, CHANNEL_MAJOR}) {
+        testShardUpdates(devices[0], 15, 10, layout);
+        testShardUpdates(devices[0], 40, 30, layout);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,112 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include "model.hpp"
+#include "neighbourhood.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// Dense host reference of an online step, every node inside the cutoff radius
+void adjustWeights(const Model &model, vector<cl_float> &weights, const cl_float *vector, const size_t bmuIndex, const double radius, const double learningRate, const double cutoffRadius) {
+    const auto channels = model.getChannelsCount();
+    const cl_float *points = &model.getPoints();
+    
+    for (auto i = 0; i < model.getNodesCount(); i++) {
+        auto dx = points[bmuIndex * 2] - points[i * 2];
+        auto dy = points[bmuIndex * 2 + 1] - points[i * 2 + 1];
+        auto distance = dx * dx + dy * dy;
+        
+        if (distance <= cutoffRadius * cutoffRadius) {
+            auto influence = learningRate * exp(-distance / (2 * radius * radius));
+            
+            for (auto j = 0; j < channels; j++) {
+                weights[i * channels + j] += influence * (vector[j] - weights[i * channels + j]);
+            }
+        }
+    }
+}
+
+// The table rows and the stencil against the dense reference and the native backend
+void test(const size_t cols, const size_t rows, const bool table) {
+    const auto channels = 3;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 20;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model expectedModel(cols, rows, channels, hexSize);
+    Model model(cols, rows, channels, hexSize);
+    
+    for (auto model : {&expectedModel, &model}) {
+        model->prepare(data, NO_NORM, RANDOM_0_1);
+        model->setMetric(EUCLIDEAN);
+    }
+    
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * nodesCount * channels);
+    
+    assert(model.getNeighbourhood().hasTable() == table);
+    
+    vector<cl_float> expectedWeights(&model.getWeights(), &model.getWeights() + nodesCount * channels);
+    
+    CLComputing computing(model, ALL_DEVICES);
+    NativeComputing nativeComputing(expectedModel);
+    
+    const auto radius = model.getTopologicalRadius();
+    
+    for (auto i = 0; i < dataCount; i++) {
+        // Uploads the input vector, the step itself is centered on any node
+        computing.bmuIndex(data[i][0], false);
+        nativeComputing.bmuIndex(data[i][0], false);
+        
+        auto bmuIndex = (size_t)rand() % nodesCount;
+        auto stepRadius = radius * (1.0 - i * 0.045);
+        
+        // Full radius, a Gaussian tail cutoff and a single node neighbourhood
+        auto cutoffRadius = i % 3 == 0 ? stepRadius : i % 3 == 1 ? stepRadius * 0.4 : 0.0;
+        
+        adjustWeights(model, expectedWeights, data[i].data(), bmuIndex, stepRadius, 0.1, cutoffRadius);
+        computing.adjustWeights(bmuIndex, stepRadius, 0.1, cutoffRadius);
+        nativeComputing.adjustWeights(bmuIndex, stepRadius, 0.1, cutoffRadius);
+    }
+    
+    computing.readModel();
+    nativeComputing.readModel();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        assert(cmpf((&model.getWeights())[i], expectedWeights[i]));
+        assert(cmpf((&expectedModel.getWeights())[i], expectedWeights[i]));
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    test(11, 7, true);
+    test(40, 30, false);
+    
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "native_kernels.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// Full vectors, a padded tail and both, for each vector width
+void test(const size_t channels) {
+    const auto cols = 6;
+    const auto rows = 5;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto vectorsCount = 7;
+    
+    Model model(cols, rows, channels, hexSize);
+    
+    cl_float *weights = &model.getWeights();
+    
+    for (auto i = 0; i < nodesCount * channels; i++) {
+        weights[i] = (cl_float)rand() / RAND_MAX;
+    }
+    
+    vector<cl_float> vectors(vectorsCount * channels);
+    
+    for (auto &value : vectors) {
+        value = (cl_float)rand() / RAND_MAX;
+    }
+    
+    CLComputing computing(model, ALL_DEVICES);
+    
+    const auto &reference = scalarKernels();
+    
+    for (auto metric : {EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, CANBERRA, COSINE, SAD, SSD, MAE, MSE}) {
+        model.setMetric(metric);
+        
+        vector<cl_float> expectedDistances(nodesCount);
+        reference.distances[metric](vectors.data(), weights, channels, 0, nodesCount, expectedDistances.data());
+        
+        computing.bmuIndex(vectors[0], false);
+        cl_float *distances = &computing.weightDistances();
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            assert(cmpf(distances[i], expectedDistances[i]));
+        }
+        
+        vector<size_t> bmuIndices(vectorsCount);
+        computing.bmuIndices(vectors[0], vectorsCount, bmuIndices.data());
+        
+        for (auto i = 0; i < vectorsCount; i++) {
+            cl_float expectedDistance;
+            
+            reference.bmu[metric](&vectors[i * channels], weights, channels, 0, nodesCount, expectedDistance);
+            reference.distances[metric](&vectors[i * channels], weights, channels, 0, nodesCount, expectedDistances.data());
+            
+            // The BMU may differ on a tie within the rounding, its distance may not
+            assert(cmpf(expectedDistances[bmuIndices[i]], expectedDistance));
+        }
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    for (auto channels : {1, 3, 4, 7, 8, 13, 16, 21, 64}) {
+        test(channels);
+    }
+    
+    return 0;
+}
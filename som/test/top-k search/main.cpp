@@ -0,0 +1,103 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include <algorithm>
+#include "model.hpp"
+#include "cl_computing.hpp"
+#include "native_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+// The device merge of the work-item lists against the native sort and the distances of single queries
+void test(const size_t channels, const DistanceMetric metric, const WeightsLayout layout) {
+    const auto cols = 13;
+    const auto rows = 11;
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 40;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model model(cols, rows, channels, hexSize);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    model.setMetric(metric);
+    
+    CLComputing computing(model, ALL_DEVICES, layout);
+    NativeComputing nativeComputing(model);
+    
+    vector<size_t> bmuIndices(dataCount);
+    computing.bmuIndices(model.getData(), dataCount, bmuIndices.data());
+    
+    for (size_t k : {1, 2, 5, 16, 20}) {
+        vector<size_t> indices(dataCount * k), nativeIndices(dataCount * k);
+        vector<cl_float> distances(dataCount * k), nativeDistances(dataCount * k);
+        
+        computing.topK(model.getData(), dataCount, k, indices.data(), distances.data());
+        nativeComputing.topK(model.getData(), dataCount, k, nativeIndices.data(), nativeDistances.data());
+        
+        for (auto i = 0; i < dataCount; i++) {
+            computing.bmuIndex((&model.getData())[i * channels], false);
+            cl_float *weightDistances = &computing.weightDistances();
+            
+            const size_t *list = indices.data() + i * k;
+            
+            assert(list[0] == bmuIndices[i]);
+            
+            for (auto j = 0; j < k; j++) {
+                auto index = indices[i * k + j];
+                
+                assert(index < nodesCount);
+                assert(cmpf(distances[i * k + j], weightDistances[index]));
+                assert(cmpf(distances[i * k + j], nativeDistances[i * k + j]));
+                
+                // Nearest first and without repetitions
+                if (j > 0) {
+                    assert(distances[i * k + j - 1] <= distances[i * k + j]);
+                    assert(find(list, list + j, index) == list + j);
+                }
+            }
+            
+            // Nothing outside the list is nearer than its last node
+            for (auto n = 0; n < nodesCount; n++) {
+                if (find(list, list + k, (size_t)n) == list + k) {
+                    assert(weightDistances[n] >= distances[i * k + k - 1] - 0.0005f);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    for (auto layout : {NODE_MAJOR, CHANNEL_MAJOR}) {
+        for (auto metric : {EUCLIDEAN, MANHATTAN, CHEBYSHEV, COSINE}) {
+            test(3, metric, layout);
+        }
+        
+        test(21, EUCLIDEAN, layout);
+    }
+    
+    return 0;
+}
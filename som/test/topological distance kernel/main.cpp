@@ -12,7 +12,7 @@
 
 #include <assert.h>
 #include "model.hpp"
-#include "computing.hpp"
+#include "cl_computing.hpp"
 
 using namespace som;
 using namespace std;
@@ -39,7 +39,7 @@ int main(int argc, const char * argv[]) {
     
     Model model(cols, rows, channels, hexSize);
 
-    Computing computing(model, ALL_DEVICES);
+    CLComputing computing(model, ALL_DEVICES);
     cl_float *distances = &computing.pointDistances(bmuIndex);
     
     test(distances, { // expected distances
@@ -0,0 +1,140 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <assert.h>
+#include <cstring>
+#include <chrono>
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool cmpf(cl_float a, cl_float b, cl_float epsilon = 0.0005f) {
+    return (fabs(a - b) < epsilon * max(1.0f, fabs(b)));
+}
+
+void assertWeightsEqual(const Model &expected, const Model &model) {
+    for (auto i = 0; i < model.getNodesCount() * model.getChannelsCount(); i++) {
+        assert(cmpf((&model.getWeights())[i], (&expected.getWeights())[i]));
+    }
+}
+
+// Batched BMU search time of the layout, in milliseconds
+double benchmark(CLComputing &computing, const Model &model) {
+    const auto count = model.getDataCount();
+    vector<size_t> bmuIndices(count);
+    
+    auto start = chrono::steady_clock::now();
+    
+    for (auto i = 0; i < 3; i++) {
+        computing.bmuIndices(model.getData(), count, bmuIndices.data());
+    }
+    
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / 3;
+}
+
+// The channel-major device weights against the node-major ones, the Model keeps the logical layout
+void test(const size_t channels, const size_t cols, const size_t rows) {
+    const auto hexSize = 5;
+    const auto nodesCount = cols * rows;
+    const auto dataCount = 100;
+    const auto batchSize = 8;
+    
+    vector<vector<cl_float>> data(dataCount, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model expectedModel(cols, rows, channels, hexSize);
+    Model model(cols, rows, channels, hexSize);
+    
+    for (auto model : {&expectedModel, &model}) {
+        model->prepare(data, NO_NORM, RANDOM_0_1);
+        model->setMetric(EUCLIDEAN);
+    }
+    
+    memcpy(&model.getWeights(), &expectedModel.getWeights(), sizeof(cl_float) * nodesCount * channels);
+    
+    CLComputing expectedComputing(expectedModel, ALL_DEVICES, NODE_MAJOR);
+    CLComputing computing(model, ALL_DEVICES, CHANNEL_MAJOR);
+    
+    assert(computing.getWeightsLayout() == CHANNEL_MAJOR);
+    
+    // Uploaded transposed, read back in the logical order
+    computing.writeModel();
+    computing.adjustWeights(0, 1.0, 0.0);
+    computing.readModel();
+    assertWeightsEqual(expectedModel, model);
+    
+    for (auto metric : {EUCLIDEAN, CHEBYSHEV, CANBERRA, COSINE}) {
+        expectedModel.setMetric(metric);
+        model.setMetric(metric);
+        
+        for (auto i = 0; i < 10; i++) {
+            auto &vector = data[i];
+            
+            auto expectedIndex = expectedComputing.bmuIndex(vector[0], true);
+            auto index = computing.bmuIndex(vector[0], true);
+            
+            cl_float *expectedDistances = &expectedComputing.weightDistances();
+            cl_float *distances = &computing.weightDistances();
+            
+            for (auto j = 0; j < nodesCount; j++) {
+                assert(cmpf(distances[j], expectedDistances[j]));
+            }
+            
+            assert(cmpf(distances[index], expectedDistances[expectedIndex]));
+            
+            expectedComputing.adjustWeights(expectedIndex, 6.0 - i * 0.5, 0.1);
+            computing.adjustWeights(expectedIndex, 6.0 - i * 0.5, 0.1);
+        }
+    }
+    
+    expectedModel.setMetric(EUCLIDEAN);
+    model.setMetric(EUCLIDEAN);
+    
+    expectedComputing.adjustWeightsBatch(4.0);
+    computing.adjustWeightsBatch(4.0);
+    
+    vector<cl_float> schedule(batchSize * 2);
+    for (auto i = 0; i < batchSize; i++) {
+        schedule[i * 2] = 4.0f;
+        schedule[i * 2 + 1] = 0.05f;
+    }
+    
+    expectedComputing.adjustWeightsMiniBatch(expectedModel.getData(), batchSize, schedule[0]);
+    computing.adjustWeightsMiniBatch(model.getData(), batchSize, schedule[0]);
+    
+    expectedComputing.readModel();
+    computing.readModel();
+    assertWeightsEqual(expectedModel, model);
+    
+    auto nodeMajorTime = benchmark(expectedComputing, expectedModel);
+    auto channelMajorTime = benchmark(computing, model);
+    
+    cout << "SOM: " << channels << " channels, BMU search node-major: " << nodeMajorTime << " ms, channel-major: " << channelMajorTime << " ms" << endl;
+}
+
+int main(int argc, const char * argv[]) {
+    srand(1);
+    
+    // The maps of different sizes share the program of their channels
+    for (auto channels : {3, 21}) {
+        test(channels, 9, 7);
+        test(channels, 13, 11);
+    }
+    
+    return 0;
+}
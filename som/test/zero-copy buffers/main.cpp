@@ -0,0 +1,81 @@
+/* Copyright 2018 Denis Silko. All rights reserved.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http:www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+
+#include <assert.h>
+#include <cstdint>
+#include "model.hpp"
+#include "cl_computing.hpp"
+
+using namespace som;
+using namespace std;
+
+bool isPageAligned(const void *memory) {
+    return (uintptr_t)memory % 4096 == 0;
+}
+
+int main(int argc, const char * argv[]) {
+    const auto channels = 3;
+    
+    vector<vector<cl_float>> data(100, vector<cl_float>(channels));
+    for (auto &vector : data) {
+        for (auto &value : vector) {
+            value = (cl_float)rand() / RAND_MAX;
+        }
+    }
+    
+    Model model(6, 5, channels, 5);
+    model.prepare(data, NO_NORM, RANDOM_0_1);
+    
+    // The arrays shared with the devices can be used in place
+    assert(isPageAligned(&model.getData()));
+    assert(isPageAligned(&model.getWeights()));
+    assert(isPageAligned(&model.getDistances()));
+    assert(isPageAligned(&model.getDistancesAccumulator()));
+    
+    const auto nodesCount = model.getNodesCount();
+    
+    for (auto layout : {NODE_MAJOR, CHANNEL_MAJOR}) {
+        CLComputing computing(model, CPU, layout);
+        
+        // Host changes reach the device after writeModel
+        cl_float *weights = &model.getWeights();
+        cl_float vector[channels] = {2.0f, 2.0f, 2.0f};
+        
+        for (auto i = 0; i < nodesCount * channels; i++) {
+            weights[i] = 0.0f;
+        }
+        
+        for (auto j = 0; j < channels; j++) {
+            weights[7 * channels + j] = vector[j];
+        }
+        
+        computing.writeModel();
+        
+        cl_float distance;
+        assert(computing.bmuIndex(vector[0], true, distance) == 7);
+        assert(distance == 0.0f);
+        
+        // Device changes reach the host after readModel
+        computing.adjustWeights(7, 100.0, 0.5);
+        computing.readModel();
+        
+        for (auto i = 0; i < nodesCount; i++) {
+            assert(i == 7 ? weights[i * channels] == 2.0f : weights[i * channels] > 0.0f);
+        }
+        
+        cl_float *distances = &computing.weightDistances();
+        assert(distances[7] == 0.0f && distances[0] > 0.0f);
+    }
+    
+    return 0;
+}